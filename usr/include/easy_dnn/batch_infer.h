@@ -0,0 +1,143 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_BATCH_INFER_H_
+#define _EASY_DNN_BATCH_INFER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Submit N independent frames of one model as one task.
+ * Items are appended to a single task handle with `hbDNNInferCtrlParam::more`
+ *    set on all but the last item, the runtime queues the task once the last
+ *    item closes it. The batch costs one task, one wait and one release
+ *    instead of one of each per frame; tensors are validated by `hbDNNInfer`.
+ * An item rejected by `hbDNNInfer` aborts the task before anything runs,
+ *    `status` tells which item was rejected, the others report
+ *    `DNN_TASK_CANCELED`, so the caller can drop the bad frame and submit
+ *    again.
+ */
+class BatchInfer {
+ public:
+  /**
+   * Submit batch inference
+   * @param[out] task_handle, nullptr if the batch was not submitted
+   * @param[out] status, one per item, 0 if the item was submitted
+   * @param[in] outputs, the size should be equal to
+   *    `batch_size` * $(`hbDNNGetOutputCount`), range of
+   *    [idx*output_count, (idx+1)*output_count) holds outputs of idx-th item
+   * @param[in] inputs, the size should be equal to
+   *    `batch_size` * $(`hbDNNGetInputCount`), range of
+   *    [idx*input_count, (idx+1)*input_count) holds inputs of idx-th item
+   * @param[in] dnn_handle
+   * @param[in] ctrl_param, shared by all items, customId of idx-th item is
+   *    `ctrl_param.customId + idx`, `more` is ignored
+   * @return 0 if success, return the error code of the rejected item
+   *    otherwise
+   */
+  static int32_t Submit(hbDNNTaskHandle_t &task_handle,
+                        std::vector<int32_t> &status,
+                        std::vector<hbDNNTensor> &outputs,
+                        std::vector<hbDNNTensor> const &inputs,
+                        hbDNNHandle_t dnn_handle,
+                        hbDNNInferCtrlParam const &ctrl_param) {
+    task_handle = nullptr;
+    int32_t input_count = 0;
+    int32_t output_count = 0;
+    int32_t ret = hbDNNGetInputCount(&input_count, dnn_handle);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    ret = hbDNNGetOutputCount(&output_count, dnn_handle);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    if (input_count <= 0 || output_count <= 0 || inputs.empty() ||
+        inputs.size() % static_cast<size_t>(input_count) != 0) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    size_t batch_size = inputs.size() / input_count;
+    if (outputs.size() != batch_size * static_cast<size_t>(output_count)) {
+      return DNN_INVALID_ARGUMENT;
+    }
+
+    status.assign(batch_size, DNN_SUCCESS);
+    hbDNNInferCtrlParam item_ctrl_param = ctrl_param;
+    for (size_t idx = 0; idx < batch_size; idx++) {
+      hbDNNTensor *item_outputs = &outputs[idx * output_count];
+      item_ctrl_param.customId = ctrl_param.customId + idx;
+      // keep the task open until the last item
+      item_ctrl_param.more = idx + 1 < batch_size ? 1 : 0;
+      ret = hbDNNInfer(&task_handle,
+                       &item_outputs,
+                       &inputs[idx * input_count],
+                       dnn_handle,
+                       &item_ctrl_param);
+      if (ret != DNN_SUCCESS) {
+        // the task is still open, nothing of it has run
+        if (task_handle != nullptr) {
+          hbDNNReleaseTask(task_handle);
+          task_handle = nullptr;
+        }
+        status.assign(batch_size, DNN_TASK_CANCELED);
+        status[idx] = ret;
+        return ret;
+      }
+    }
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Wait the batch done
+   * @param[inout] status, per item status, set to the wait result
+   * @param[in] task_handle
+   * @param[in] timeout, timeout of milliseconds
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t WaitDone(std::vector<int32_t> &status,
+                          hbDNNTaskHandle_t task_handle,
+                          int32_t timeout) {
+    if (task_handle == nullptr) {
+      return DNN_INVALID_TASK_HANDLE;
+    }
+    int32_t ret = hbDNNWaitTaskDone(task_handle, timeout);
+    status.assign(status.size(), ret);
+    return ret;
+  }
+
+  /**
+   * Release the task handle of the batch
+   * @param[inout] task_handle, reset to nullptr after release
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Release(hbDNNTaskHandle_t &task_handle) {
+    if (task_handle == nullptr) {
+      return DNN_SUCCESS;
+    }
+    int32_t ret = hbDNNReleaseTask(task_handle);
+    task_handle = nullptr;
+    return ret;
+  }
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_BATCH_INFER_H_
@@ -0,0 +1,235 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_BATCH_RESIZE_H_
+#define _EASY_DNN_BATCH_RESIZE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/image_convert.h"
+#include "easy_dnn/status.h"
+#include "easy_dnn/thread_pool.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Resize many rois of one image, e.g. crops of all detections for a second
+ *    stage model.
+ * `hbDNNResize` takes one roi and `hbDNNResizeCtrlParam` has no `more` flag
+ *    to chain tasks, so every roi is its own task. `Run` submits them all
+ *    before the first wait and resizes the rois the resizer did not accept,
+ *    e.g. when it is busy or unavailable, on CPU with
+ *    `ImageConvert::ResizeNv12` while the accepted ones run.
+ */
+class BatchResize {
+ public:
+  /**
+   * Submit one resize task per roi
+   * @param[out] task_handles, one per roi, nullptr if the item failed
+   * @param[out] status, one per roi, 0 if the item was submitted
+   * @param[in] outputs, one per roi
+   * @param[in] input
+   * @param[in] rois
+   * @param[in] ctrl_param, shared by all items
+   * @return 0 if all items were submitted, return the first item error code
+   *    otherwise
+   */
+  static int32_t Submit(std::vector<hbDNNTaskHandle_t> &task_handles,
+                        std::vector<int32_t> &status,
+                        std::vector<hbDNNTensor> &outputs,
+                        hbDNNTensor const &input,
+                        std::vector<hbDNNRoi> const &rois,
+                        hbDNNResizeCtrlParam const &ctrl_param) {
+    if (outputs.size() != rois.size()) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    task_handles.assign(rois.size(), nullptr);
+    status.assign(rois.size(), DNN_SUCCESS);
+    int32_t first_error = DNN_SUCCESS;
+    hbDNNResizeCtrlParam item_ctrl_param = ctrl_param;
+    for (size_t idx = 0; idx < rois.size(); idx++) {
+      status[idx] = hbDNNResize(&task_handles[idx],
+                                &outputs[idx],
+                                &input,
+                                &rois[idx],
+                                &item_ctrl_param);
+      if (status[idx] != DNN_SUCCESS) {
+        task_handles[idx] = nullptr;
+        if (first_error == DNN_SUCCESS) {
+          first_error = status[idx];
+        }
+      }
+    }
+    return first_error;
+  }
+
+  /**
+   * Wait submitted items in order, stop at the first failed wait
+   * @param[inout] status, the failed item is updated with the wait result
+   * @param[in] task_handles
+   * @param[in] timeout, timeout of milliseconds for each item
+   * @return 0 if all items finished successfully, return the error of the
+   *    failed wait otherwise, items after it are not waited
+   */
+  static int32_t WaitDone(std::vector<int32_t> &status,
+                          std::vector<hbDNNTaskHandle_t> const &task_handles,
+                          int32_t timeout) {
+    if (status.size() != task_handles.size()) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    for (size_t idx = 0; idx < task_handles.size(); idx++) {
+      if (task_handles[idx] == nullptr) {
+        continue;
+      }
+      status[idx] = hbDNNWaitTaskDone(task_handles[idx], timeout);
+      if (status[idx] != DNN_SUCCESS) {
+        return status[idx];
+      }
+    }
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Release task handles
+   * @param[inout] task_handles, reset to nullptr after release
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Release(std::vector<hbDNNTaskHandle_t> &task_handles) {
+    int32_t first_error = DNN_SUCCESS;
+    for (auto &task_handle : task_handles) {
+      if (task_handle == nullptr) {
+        continue;
+      }
+      int32_t ret = hbDNNReleaseTask(task_handle);
+      if (ret != DNN_SUCCESS && first_error == DNN_SUCCESS) {
+        first_error = ret;
+      }
+      task_handle = nullptr;
+    }
+    return first_error;
+  }
+
+  /**
+   * Resize rois on CPU, items run in parallel on `ThreadPool`
+   * @param[out] status, one per roi
+   * @param[in] outputs, one per roi, clean cache after call if memory is
+   *    cached
+   * @param[in] input, invalidate cache before call if memory is cached
+   * @param[in] rois
+   * @return 0 if all items succeeded, return the first item error code
+   *    otherwise
+   */
+  static int32_t ResizeOnCpu(std::vector<int32_t> &status,
+                             std::vector<hbDNNTensor> &outputs,
+                             hbDNNTensor const &input,
+                             std::vector<hbDNNRoi> const &rois) {
+    if (outputs.size() != rois.size()) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    status.assign(rois.size(), DNN_SUCCESS);
+    std::vector<size_t> items(rois.size());
+    for (size_t idx = 0; idx < rois.size(); idx++) {
+      items[idx] = idx;
+    }
+    RunOnCpu(status, outputs, input, rois, items);
+    return FirstError(status);
+  }
+
+  /**
+   * Submit all items, resize items which could not be submitted on CPU if
+   *    `cpu_fallback` is set while the submitted ones run, then wait and
+   *    release the submitted ones
+   * @param[out] status, one per roi
+   * @param[out] task_handles, all nullptr if every wait succeeded. Otherwise
+   *    the task whose wait failed and the tasks after it are kept, they may
+   *    still be writing their outputs: wait again with `WaitDone` or
+   *    `Release` them
+   * @param[in] outputs, one per roi
+   * @param[in] input
+   * @param[in] rois
+   * @param[in] ctrl_param, shared by all items
+   * @param[in] timeout, timeout of milliseconds for each item
+   * @param[in] cpu_fallback
+   * @return 0 if all items succeeded, return the error of the failed wait or
+   *    the first item error code otherwise
+   */
+  static int32_t Run(std::vector<int32_t> &status,
+                     std::vector<hbDNNTaskHandle_t> &task_handles,
+                     std::vector<hbDNNTensor> &outputs,
+                     hbDNNTensor const &input,
+                     std::vector<hbDNNRoi> const &rois,
+                     hbDNNResizeCtrlParam const &ctrl_param,
+                     int32_t timeout,
+                     bool cpu_fallback) {
+    if (outputs.size() != rois.size()) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    Submit(task_handles, status, outputs, input, rois, ctrl_param);
+    if (cpu_fallback) {
+      std::vector<size_t> rejected;
+      for (size_t idx = 0; idx < task_handles.size(); idx++) {
+        if (task_handles[idx] == nullptr) {
+          rejected.push_back(idx);
+        }
+      }
+      RunOnCpu(status, outputs, input, rois, rejected);
+    }
+    int32_t ret = WaitDone(status, task_handles, timeout);
+    // release up to the failed wait, handles from there on stay with the
+    // caller
+    for (size_t idx = 0; idx < task_handles.size(); idx++) {
+      if (task_handles[idx] == nullptr) {
+        continue;
+      }
+      if (status[idx] != DNN_SUCCESS) {
+        break;
+      }
+      hbDNNReleaseTask(task_handles[idx]);
+      task_handles[idx] = nullptr;
+    }
+    return ret != DNN_SUCCESS ? ret : FirstError(status);
+  }
+
+ private:
+  static void RunOnCpu(std::vector<int32_t> &status,
+                       std::vector<hbDNNTensor> &outputs,
+                       hbDNNTensor const &input,
+                       std::vector<hbDNNRoi> const &rois,
+                       std::vector<size_t> const &items) {
+    ThreadPool::GetInstance().ParallelFor(
+        items.size(), 1U, [&](size_t b, size_t e) {
+          for (size_t i = b; i < e; i++) {
+            size_t idx = items[i];
+            status[idx] =
+                ImageConvert::ResizeNv12(outputs[idx], input, rois[idx]);
+          }
+        });
+  }
+
+  static int32_t FirstError(std::vector<int32_t> const &status) {
+    for (int32_t item_status : status) {
+      if (item_status != DNN_SUCCESS) {
+        return item_status;
+      }
+    }
+    return DNN_SUCCESS;
+  }
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_BATCH_RESIZE_H_
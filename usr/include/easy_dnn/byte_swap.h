@@ -0,0 +1,170 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_BYTE_SWAP_H_
+#define _EASY_DNN_BYTE_SWAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Endianness conversion of 2, 4 and 8 byte elements, the building block
+ *    for fusing `hbDNNConvertEndianness` into other CPU passes.
+ * Vector helpers reverse the bytes of every element of a 16 byte register
+ *    (NEON `vrev`, SSE2 shuffles and shifts), so kernels swap right after
+ *    a load or before a store instead of making another pass.
+ */
+class ByteSwap {
+ public:
+  /**
+   * Reverse the bytes of one value
+   * @param[in] value
+   * @return swapped value
+   */
+  template <typename T>
+  static T Swap(T value) {
+    static_assert(sizeof(T) == 1U || sizeof(T) == 2U || sizeof(T) == 4U ||
+                      sizeof(T) == 8U,
+                  "unsupported element size");
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    for (size_t i = 0U; i < sizeof(T) / 2U; i++) {
+      uint8_t byte = bytes[i];
+      bytes[i] = bytes[sizeof(T) - 1U - i];
+      bytes[sizeof(T) - 1U - i] = byte;
+    }
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+  }
+
+  /**
+   * Copy elements and reverse their bytes, `dst` may equal `src`
+   * @param[out] dst
+   * @param[in] src
+   * @param[in] count, element count
+   * @param[in] element_size, 1, 2, 4 or 8
+   */
+  static void Swap(void *dst,
+                   void const *src,
+                   size_t count,
+                   size_t element_size) {
+    auto *d = static_cast<uint8_t *>(dst);
+    auto const *s = static_cast<uint8_t const *>(src);
+    size_t bytes = count * element_size;
+    size_t i = 0U;
+    switch (element_size) {
+      case 2U:
+        for (; i + 16U <= bytes; i += 16U) {
+          Store(d + i, Vector16(Load(s + i)));
+        }
+        break;
+      case 4U:
+        for (; i + 16U <= bytes; i += 16U) {
+          Store(d + i, Vector32(Load(s + i)));
+        }
+        break;
+      case 8U:
+        for (; i + 16U <= bytes; i += 16U) {
+          Store(d + i, Vector64(Load(s + i)));
+        }
+        break;
+      default:
+        if (d != s) {
+          memcpy(d, s, bytes);
+        }
+        return;
+    }
+    for (; i < bytes; i += element_size) {
+      for (size_t j = 0U; j < element_size / 2U; j++) {
+        uint8_t byte = s[i + j];
+        d[i + j] = s[i + element_size - 1U - j];
+        d[i + element_size - 1U - j] = byte;
+      }
+    }
+  }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  static uint8x16_t Load(uint8_t const *src) { return vld1q_u8(src); }
+  static void Store(uint8_t *dst, uint8x16_t value) { vst1q_u8(dst, value); }
+  static uint8x16_t Vector16(uint8x16_t value) { return vrev16q_u8(value); }
+  static uint8x16_t Vector32(uint8x16_t value) { return vrev32q_u8(value); }
+  static uint8x16_t Vector64(uint8x16_t value) { return vrev64q_u8(value); }
+#elif defined(__SSE2__)
+  static __m128i Load(uint8_t const *src) {
+    return _mm_loadu_si128(reinterpret_cast<__m128i const *>(src));
+  }
+
+  static void Store(uint8_t *dst, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), value);
+  }
+
+  static __m128i Vector16(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+  }
+
+  // reverse the 16 bit halves, then the bytes of each half
+  static __m128i Vector32(__m128i value) {
+    value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+    return Vector16(_mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1)));
+  }
+
+  static __m128i Vector64(__m128i value) {
+    value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+    return Vector16(_mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3)));
+  }
+#else
+  struct Register {
+    uint8_t bytes[16];
+  };
+
+  static Register Load(uint8_t const *src) {
+    Register value;
+    memcpy(value.bytes, src, sizeof(value.bytes));
+    return value;
+  }
+
+  static void Store(uint8_t *dst, Register const &value) {
+    memcpy(dst, value.bytes, sizeof(value.bytes));
+  }
+
+  static Register Vector16(Register value) { return Reverse(value, 2U); }
+  static Register Vector32(Register value) { return Reverse(value, 4U); }
+  static Register Vector64(Register value) { return Reverse(value, 8U); }
+
+ private:
+  static Register Reverse(Register value, size_t element_size) {
+    Register swapped;
+    for (size_t i = 0U; i < sizeof(value.bytes); i++) {
+      size_t base = i - i % element_size;
+      size_t index = base + element_size - 1U - i % element_size;
+      swapped.bytes[i] = value.bytes[index];
+    }
+    return swapped;
+  }
+#endif
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_BYTE_SWAP_H_
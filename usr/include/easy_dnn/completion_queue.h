@@ -0,0 +1,296 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_COMPLETION_QUEUE_H_
+#define _EASY_DNN_COMPLETION_QUEUE_H_
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+struct TaskCompletion {
+  hbDNNTaskHandle_t task_handle;
+  int32_t status;
+  int64_t custom_id;
+  int64_t attach_time;  // time of us, steady clock
+  int64_t done_time;    // time of us, steady clock
+};
+
+/**
+ * Bounded lock-free ring, safe for multiple producers and consumers.
+ *    capacity is rounded up to power of 2
+ */
+template <typename T>
+class BoundedRing {
+ public:
+  explicit BoundedRing(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    cells_.reset(new Cell[size]);
+    mask_ = size - 1;
+    for (size_t i = 0; i < size; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * Push one item
+   * @param[in] data
+   * @return false if ring is full
+   */
+  bool Push(T const &data) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = cells_[pos & mask_];
+      size_t seq = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          cell.data = data;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Pop one item
+   * @param[out] data
+   * @return false if ring is empty
+   */
+  bool Pop(T &data) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = cells_[pos & mask_];
+      size_t seq = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          data = cell.data;
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  // keep producer and consumer positions on separate cache lines
+  char pad0_[64];
+  std::atomic<size_t> enqueue_pos_;
+  char pad1_[64];
+  std::atomic<size_t> dequeue_pos_;
+  char pad2_[64];
+};
+
+/**
+ * Completion queue backed by a lock-free ring and an eventfd.
+ * Tasks attached to the queue post a completion record when done and make
+ *    the fd readable, so an epoll/poll based loop can drive many in-flight
+ *    tasks from one thread and reap their completions in batches.
+ * At most `capacity` tasks can be attached and not reaped at the same time,
+ *    the ring never overflows.
+ * The queue must outlive all tasks attached to it.
+ */
+class CompletionQueue {
+ public:
+  /**
+   * Create a completion queue
+   * @param[out] queue
+   * @param[in] capacity, max count of attached and not reaped tasks
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(std::shared_ptr<CompletionQueue> &queue,
+                        uint32_t capacity = 1024U) {
+    if (capacity == 0U) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    int32_t fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+      return DNN_OUT_OF_MEMORY;
+    }
+    queue.reset(new CompletionQueue(fd, capacity));
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Get the eventfd, it becomes readable when completions are available
+   * @return fd
+   */
+  int32_t GetFd() const { return fd_; }
+
+  /**
+   * Attach a submitted task, its completion will be posted to this queue.
+   *    It takes over the task done callback of the task
+   * @param[in] task_handle
+   * @param[in] custom_id, correlation key reported in the completion,
+   *    usually `hbDNNInferCtrlParam::customId`
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Attach(hbDNNTaskHandle_t task_handle, int64_t custom_id = 0) {
+    if (task_handle == nullptr) {
+      return DNN_INVALID_TASK_HANDLE;
+    }
+    uint32_t index = 0U;
+    if (!free_slots_.Pop(index)) {
+      return DNN_TASK_NUM_EXCEED_LIMIT;
+    }
+    Slot &slot = slots_[index];
+    slot.custom_id = custom_id;
+    slot.attach_time = NowUs();
+    int32_t ret =
+        hbDNNSetTaskDoneCb(task_handle, &CompletionQueue::OnTaskDone, &slot);
+    if (ret != DNN_SUCCESS) {
+      free_slots_.Push(index);
+    }
+    return ret;
+  }
+
+  /**
+   * Reap completed tasks without blocking
+   * @param[out] completions, reaped completions are appended
+   * @param[in] max_count, reap at most `max_count` completions, 0 for all
+   * @return count of reaped completions
+   */
+  int32_t Reap(std::vector<TaskCompletion> &completions, size_t max_count) {
+    // Consume the fd, then reset the flag, then drain. A completion whose
+    // `Notify` saw the flag set is drained below, the exchange acquires its
+    // push. Any later completion writes the fd again.
+    uint64_t counter = 0;
+    while (read(fd_, &counter, sizeof(counter)) < 0 && errno == EINTR) {
+    }
+    signaled_.exchange(false);
+    size_t count = 0;
+    Record record;
+    while ((max_count == 0 || count < max_count) && done_.Pop(record)) {
+      completions.push_back(record.completion);
+      free_slots_.Push(record.slot);
+      count++;
+    }
+    if (max_count > 0 && count == max_count) {
+      // leftovers, keep the fd readable
+      Notify();
+    }
+    return static_cast<int32_t>(count);
+  }
+
+  ~CompletionQueue() { close(fd_); }
+
+ private:
+  struct Slot {
+    CompletionQueue *queue;
+    uint32_t index;
+    int64_t custom_id;
+    int64_t attach_time;
+  };
+
+  struct Record {
+    TaskCompletion completion;
+    uint32_t slot;
+  };
+
+  CompletionQueue(int32_t fd, uint32_t capacity)
+      : fd_(fd),
+        slots_(capacity),
+        free_slots_(capacity),
+        done_(capacity),
+        signaled_(false) {
+    for (uint32_t i = 0; i < capacity; i++) {
+      slots_[i].queue = this;
+      slots_[i].index = i;
+      free_slots_.Push(i);
+    }
+  }
+
+  static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  static void OnTaskDone(hbDNNTaskHandle_t task_handle,
+                         int32_t status,
+                         void *userdata) {
+    auto *slot = static_cast<Slot *>(userdata);
+    Record record;
+    record.completion.task_handle = task_handle;
+    record.completion.status = status;
+    record.completion.custom_id = slot->custom_id;
+    record.completion.attach_time = slot->attach_time;
+    record.completion.done_time = NowUs();
+    record.slot = slot->index;
+    // never full, slot count equals ring capacity
+    slot->queue->done_.Push(record);
+    slot->queue->Notify();
+  }
+
+  void Notify() {
+    // one write per reap round is enough to wake up the poller
+    if (signaled_.exchange(true)) {
+      return;
+    }
+    uint64_t one = 1;
+    while (write(fd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+  }
+
+ private:
+  int32_t fd_;
+  std::vector<Slot> slots_;
+  BoundedRing<uint32_t> free_slots_;
+  BoundedRing<Record> done_;
+  std::atomic<bool> signaled_;
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_COMPLETION_QUEUE_H_
@@ -0,0 +1,219 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_CORE_DISPATCHER_H_
+#define _EASY_DNN_CORE_DISPATCHER_H_
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "dnn/hb_dnn.h"
+#include "dnn/hb_dnn_ext.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+typedef enum {
+  // cycle through cores
+  DISPATCH_POLICY_ROUND_ROBIN = 0,
+  // core with the least queued estimated time
+  DISPATCH_POLICY_LEAST_WORK,
+  // keep a model on the core it last ran on, unless that core is behind the
+  //    least loaded core by more than one run of the model
+  DISPATCH_POLICY_MODEL_AFFINITY,
+} DispatchPolicy;
+
+struct CoreTicket {
+  int32_t bpu_core_id;
+  int32_t estimate_time;  // time of us
+};
+
+struct CoreStatistics {
+  int32_t queue_depth;      // tasks dispatched and not released
+  int64_t queued_work;      // estimated time of queued tasks, time of us
+  int64_t busy_time;        // time with at least one queued task, time of us
+  uint64_t dispatch_count;  // tasks dispatched in total
+};
+
+/**
+ * Pick a BPU core for tasks which would otherwise use `HB_BPU_CORE_ANY`.
+ * Call `Acquire` before submission and use `ticket.bpu_core_id` as
+ *    `hbDNNInferCtrlParam::bpuCoreId`, call `Release` once the task is done.
+ *    Queued work is estimated by `hbDNNGetEstimateLatency`.
+ * Thread safe.
+ */
+class CoreDispatcher {
+ public:
+  /**
+   * Create a dispatcher
+   * @param[out] dispatcher
+   * @param[in] policy
+   * @param[in] core_count, cores are `HB_BPU_CORE_0` << [0, core_count)
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(std::shared_ptr<CoreDispatcher> &dispatcher,
+                        DispatchPolicy policy = DISPATCH_POLICY_LEAST_WORK,
+                        int32_t core_count = 2) {
+    if (core_count <= 0 || core_count > 16 ||
+        policy < DISPATCH_POLICY_ROUND_ROBIN ||
+        policy > DISPATCH_POLICY_MODEL_AFFINITY) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    dispatcher.reset(new CoreDispatcher(policy, core_count));
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Change dispatch policy, takes effect on next `Acquire`
+   * @param[in] policy
+   */
+  void SetPolicy(DispatchPolicy policy) {
+    std::lock_guard<std::mutex> lck{mutex_};
+    policy_ = policy;
+  }
+
+  /**
+   * Pick a core for one task of the model
+   * @param[out] ticket
+   * @param[in] dnn_handle
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Acquire(CoreTicket &ticket, hbDNNHandle_t dnn_handle) {
+    int32_t estimate_time = 0;
+    int32_t ret = hbDNNGetEstimateLatency(&estimate_time, dnn_handle);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    std::lock_guard<std::mutex> lck{mutex_};
+    int32_t least = 0;
+    for (int32_t i = 1; i < static_cast<int32_t>(cores_.size()); i++) {
+      if (cores_[i].queued_work < cores_[least].queued_work) {
+        least = i;
+      }
+    }
+    int32_t index = least;
+    if (policy_ == DISPATCH_POLICY_ROUND_ROBIN) {
+      index = next_core_;
+      next_core_ = (next_core_ + 1) % static_cast<int32_t>(cores_.size());
+    } else if (policy_ == DISPATCH_POLICY_MODEL_AFFINITY) {
+      auto it = affinity_.find(dnn_handle);
+      if (it != affinity_.end() &&
+          cores_[it->second].queued_work - cores_[least].queued_work <=
+              estimate_time) {
+        index = it->second;
+      }
+      affinity_[dnn_handle] = index;
+    }
+
+    Core &core = cores_[index];
+    if (core.queue_depth == 0) {
+      core.busy_since = NowUs();
+    }
+    core.queue_depth++;
+    core.queued_work += estimate_time;
+    core.dispatch_count++;
+    ticket.bpu_core_id = HB_BPU_CORE_0 << index;
+    ticket.estimate_time = estimate_time;
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Release the core picked by `Acquire` once the task is done
+   * @param[in] ticket
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Release(CoreTicket const &ticket) {
+    int32_t index = CoreIndex(ticket.bpu_core_id);
+    if (index < 0) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lck{mutex_};
+    Core &core = cores_[index];
+    if (core.queue_depth <= 0) {
+      return DNN_API_USE_ERROR;
+    }
+    core.queue_depth--;
+    core.queued_work -= ticket.estimate_time;
+    if (core.queue_depth == 0) {
+      core.queued_work = 0;
+      core.busy_time += NowUs() - core.busy_since;
+    }
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Get statistics of one core
+   * @param[out] statistics
+   * @param[in] bpu_core_id, one of `HB_BPU_CORE_0`, `HB_BPU_CORE_1` ...
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t GetCoreStatistics(CoreStatistics &statistics, int32_t bpu_core_id) {
+    int32_t index = CoreIndex(bpu_core_id);
+    if (index < 0) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lck{mutex_};
+    Core const &core = cores_[index];
+    statistics.queue_depth = core.queue_depth;
+    statistics.queued_work = core.queued_work;
+    statistics.busy_time = core.busy_time;
+    if (core.queue_depth > 0) {
+      statistics.busy_time += NowUs() - core.busy_since;
+    }
+    statistics.dispatch_count = core.dispatch_count;
+    return DNN_SUCCESS;
+  }
+
+ private:
+  struct Core {
+    int32_t queue_depth{0};
+    int64_t queued_work{0};
+    int64_t busy_time{0};
+    int64_t busy_since{0};
+    uint64_t dispatch_count{0U};
+  };
+
+  CoreDispatcher(DispatchPolicy policy, int32_t core_count)
+      : policy_(policy), cores_(core_count) {}
+
+  static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  int32_t CoreIndex(int32_t bpu_core_id) const {
+    for (int32_t i = 0; i < static_cast<int32_t>(cores_.size()); i++) {
+      if (bpu_core_id == (HB_BPU_CORE_0 << i)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+ private:
+  std::mutex mutex_;
+  DispatchPolicy policy_;
+  std::vector<Core> cores_;
+  std::map<hbDNNHandle_t, int32_t> affinity_;
+  int32_t next_core_{0};
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_CORE_DISPATCHER_H_
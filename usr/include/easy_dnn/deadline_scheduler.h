@@ -0,0 +1,534 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_DEADLINE_SCHEDULER_H_
+#define _EASY_DNN_DEADLINE_SCHEDULER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dnn/hb_dnn.h"
+#include "dnn/hb_dnn_ext.h"
+#include "easy_dnn/status.h"
+#include "easy_dnn/task_timeline.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+struct DeadlineTaskResult {
+  int64_t custom_id;
+  int32_t status;
+  int32_t bpu_core_id;
+  int64_t deadline;     // time of us, steady clock
+  int64_t submit_time;    // time of us, steady clock
+  int64_t dispatch_time;  // time of us, steady clock, 0 if not dispatched
+  int64_t done_time;      // time of us, steady clock
+  bool deadline_missed;
+};
+
+using DeadlineTaskCallback = std::function<void(DeadlineTaskResult const &)>;
+
+/**
+ * Earliest-deadline-first scheduler in front of `hbDNNInfer`.
+ * Submitted tasks are held in one queue per `bpuCoreId` and ordered by their
+ *    absolute deadline. Only `max_inflight_per_core` tasks per queue are
+ *    handed to the runtime at a time, so a task with an earlier deadline
+ *    overtakes queued tasks of other streams regardless of their static
+ *    priority.
+ * A task is predicted late at dispatch when now plus
+ *    `hbDNNGetEstimateLatency` is past its deadline, it can be dropped then
+ *    (see `SetDropExpired`). A task which ran and finished after its
+ *    deadline is reported with `deadline_missed`.
+ * Queued tasks can be canceled by `customId`, and `SubmitReplacePending`
+ *    drops older queued frames of the same `customId`, so stale frames are
+ *    shed under overload instead of growing the queue. Tasks already handed
+ *    to the runtime are not canceled.
+ * Callbacks run on the scheduler thread, task handles are released by the
+ *    scheduler. Tensors must stay valid until the callback of the task.
+ */
+class DeadlineScheduler {
+ public:
+  struct Statistics {
+    uint64_t submitted{0U};
+    uint64_t completed{0U};
+    uint64_t failed{0U};  // rejected by the runtime or finished with error
+    uint64_t deadline_missed{0U};  // of tasks which ran
+    uint64_t dropped{0U};
+    uint64_t canceled{0U};
+  };
+
+  /**
+   * Create a scheduler
+   * @param[out] scheduler
+   * @param[in] max_inflight_per_core, count of tasks handed to the runtime
+   *    per core queue at the same time
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(std::shared_ptr<DeadlineScheduler> &scheduler,
+                        int32_t max_inflight_per_core = 1) {
+    if (max_inflight_per_core <= 0) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    scheduler.reset(new DeadlineScheduler(max_inflight_per_core));
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Get current time in the clock used by deadlines
+   * @return time of us
+   */
+  static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /**
+   * Submit a task
+   * @param[in] dnn_handle
+   * @param[in] inputs, the size should be equal to $(`hbDNNGetInputCount`)
+   * @param[in] outputs, the size should be equal to $(`hbDNNGetOutputCount`)
+   * @param[in] ctrl_param, `bpuCoreId` selects the queue
+   * @param[in] deadline, absolute time of us, see `NowUs`
+   * @param[in] callback, invoked once the task is done or dropped
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Submit(hbDNNHandle_t dnn_handle,
+                 std::vector<hbDNNTensor> const &inputs,
+                 std::vector<hbDNNTensor> const &outputs,
+                 hbDNNInferCtrlParam const &ctrl_param,
+                 int64_t deadline,
+                 DeadlineTaskCallback callback) {
+    return Enqueue(dnn_handle,
+                   inputs,
+                   outputs,
+                   ctrl_param,
+                   deadline,
+                   std::move(callback),
+                   false);
+  }
+
+  /**
+   * Submit a task, queued tasks with the same `ctrl_param.customId` are
+   *    canceled atomically, they are reported with status `DNN_TASK_CANCELED`
+   * @param[in] dnn_handle
+   * @param[in] inputs, the size should be equal to $(`hbDNNGetInputCount`)
+   * @param[in] outputs, the size should be equal to $(`hbDNNGetOutputCount`)
+   * @param[in] ctrl_param, `bpuCoreId` selects the queue
+   * @param[in] deadline, absolute time of us, see `NowUs`
+   * @param[in] callback, invoked once the task is done, dropped or canceled
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t SubmitReplacePending(hbDNNHandle_t dnn_handle,
+                               std::vector<hbDNNTensor> const &inputs,
+                               std::vector<hbDNNTensor> const &outputs,
+                               hbDNNInferCtrlParam const &ctrl_param,
+                               int64_t deadline,
+                               DeadlineTaskCallback callback) {
+    return Enqueue(dnn_handle,
+                   inputs,
+                   outputs,
+                   ctrl_param,
+                   deadline,
+                   std::move(callback),
+                   true);
+  }
+
+  /**
+   * Cancel queued tasks with the given custom id, they are reported with
+   *    status `DNN_TASK_CANCELED`
+   * @param[in] custom_id
+   * @return count of canceled tasks
+   */
+  int32_t Cancel(int64_t custom_id) {
+    int32_t count = 0;
+    {
+      std::lock_guard<std::mutex> lck{mutex_};
+      count = CancelPending(custom_id);
+    }
+    if (count > 0) {
+      cv_.notify_one();
+    }
+    return count;
+  }
+
+  /**
+   * Drop tasks which are predicted to miss their deadline at dispatch time,
+   *    they are reported with status `DNN_TIMEOUT`. Disabled by default
+   * @param[in] drop_expired
+   */
+  void SetDropExpired(bool drop_expired) {
+    std::lock_guard<std::mutex> lck{mutex_};
+    drop_expired_ = drop_expired;
+  }
+
+  /**
+   * Record "queued" (submit to dispatch) and "running" (dispatch to done)
+   *    spans of every task into the timeline
+   * @param[in] timeline, nullptr to disable
+   */
+  void SetTimeline(std::shared_ptr<TaskTimeline> timeline) {
+    std::lock_guard<std::mutex> lck{mutex_};
+    timeline_ = std::move(timeline);
+  }
+
+  /**
+   * Get statistics
+   * @return statistics
+   */
+  Statistics GetStatistics() {
+    std::lock_guard<std::mutex> lck{mutex_};
+    return statistics_;
+  }
+
+  /**
+   * Wait until queued and in-flight tasks are done, then stop the scheduler
+   */
+  ~DeadlineScheduler() {
+    {
+      std::lock_guard<std::mutex> lck{mutex_};
+      stopping_ = true;
+    }
+    cv_.notify_one();
+    worker_.join();
+  }
+
+ private:
+  struct PendingTask {
+    DeadlineScheduler *scheduler;
+    hbDNNHandle_t dnn_handle;
+    std::vector<hbDNNTensor> inputs;
+    std::vector<hbDNNTensor> outputs;
+    hbDNNInferCtrlParam ctrl_param;
+    DeadlineTaskCallback callback;
+    int64_t deadline;
+    int64_t submit_time;
+    int64_t dispatch_time{0};
+    uint64_t sequence;
+    hbDNNTaskHandle_t task_handle{nullptr};
+    int32_t status{DNN_SUCCESS};
+    bool dropped{false};
+    bool canceled{false};
+  };
+
+  struct EarlierDeadline {
+    bool operator()(std::shared_ptr<PendingTask> const &lhs,
+                    std::shared_ptr<PendingTask> const &rhs) const {
+      if (lhs->deadline != rhs->deadline) {
+        return lhs->deadline < rhs->deadline;
+      }
+      return lhs->sequence < rhs->sequence;
+    }
+  };
+
+  struct CoreQueue {
+    std::set<std::shared_ptr<PendingTask>, EarlierDeadline> pending;
+    int32_t inflight{0};
+  };
+
+  explicit DeadlineScheduler(int32_t max_inflight_per_core)
+      : max_inflight_per_core_(max_inflight_per_core) {
+    worker_ = std::thread(&DeadlineScheduler::Run, this);
+  }
+
+  int32_t Enqueue(hbDNNHandle_t dnn_handle,
+                  std::vector<hbDNNTensor> const &inputs,
+                  std::vector<hbDNNTensor> const &outputs,
+                  hbDNNInferCtrlParam const &ctrl_param,
+                  int64_t deadline,
+                  DeadlineTaskCallback callback,
+                  bool replace_pending) {
+    if (dnn_handle == nullptr || inputs.empty() || outputs.empty()) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    std::shared_ptr<PendingTask> task(new PendingTask());
+    task->scheduler = this;
+    task->dnn_handle = dnn_handle;
+    task->inputs = inputs;
+    task->outputs = outputs;
+    task->ctrl_param = ctrl_param;
+    task->callback = std::move(callback);
+    task->deadline = deadline;
+    task->submit_time = NowUs();
+    {
+      std::lock_guard<std::mutex> lck{mutex_};
+      if (stopping_) {
+        return DNN_API_USE_ERROR;
+      }
+      if (replace_pending) {
+        CancelPending(ctrl_param.customId);
+      }
+      task->sequence = sequence_++;
+      queues_[ctrl_param.bpuCoreId].pending.insert(task);
+      pending_ids_.insert(std::make_pair(ctrl_param.customId, task));
+      statistics_.submitted++;
+    }
+    cv_.notify_one();
+    return DNN_SUCCESS;
+  }
+
+  int32_t CancelPending(int64_t custom_id) {
+    int32_t count = 0;
+    auto range = pending_ids_.equal_range(custom_id);
+    for (auto it = range.first; it != range.second; ++it) {
+      std::shared_ptr<PendingTask> &task = it->second;
+      queues_[task->ctrl_param.bpuCoreId].pending.erase(task);
+      task->status = DNN_TASK_CANCELED;
+      task->canceled = true;
+      canceled_.push_back(task);
+      count++;
+    }
+    pending_ids_.erase(range.first, range.second);
+    return count;
+  }
+
+  void RemovePendingId(std::shared_ptr<PendingTask> const &task) {
+    auto range = pending_ids_.equal_range(task->ctrl_param.customId);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == task) {
+        pending_ids_.erase(it);
+        return;
+      }
+    }
+  }
+
+  static void OnTaskDone(hbDNNTaskHandle_t task_handle,
+                         int32_t status,
+                         void *userdata) {
+    auto *task = static_cast<PendingTask *>(userdata);
+    DeadlineScheduler *scheduler = task->scheduler;
+    // notify under the lock, the scheduler may be destroyed right after
+    std::lock_guard<std::mutex> lck{scheduler->mutex_};
+    auto it = scheduler->running_.find(task_handle);
+    if (it == scheduler->running_.end()) {
+      return;
+    }
+    it->second->status = status;
+    scheduler->finished_.push_back(it->second);
+    scheduler->running_.erase(it);
+    scheduler->cv_.notify_one();
+  }
+
+  bool HasWork() {
+    if (!finished_.empty() || !canceled_.empty()) {
+      return true;
+    }
+    for (auto &queue : queues_) {
+      if (!queue.second.pending.empty() &&
+          queue.second.inflight < max_inflight_per_core_) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool Idle() {
+    if (!finished_.empty() || !canceled_.empty() || !running_.empty()) {
+      return false;
+    }
+    for (auto &queue : queues_) {
+      if (!queue.second.pending.empty() || queue.second.inflight > 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Run() {
+    std::unique_lock<std::mutex> lck{mutex_};
+    for (;;) {
+      cv_.wait(lck, [this] { return HasWork() || (stopping_ && Idle()); });
+      if (stopping_ && Idle()) {
+        break;
+      }
+
+      std::vector<std::shared_ptr<PendingTask>> finished;
+      finished.swap(finished_);
+      for (auto &task : finished) {
+        queues_[task->ctrl_param.bpuCoreId].inflight--;
+      }
+      std::vector<std::shared_ptr<PendingTask>> canceled;
+      canceled.swap(canceled_);
+      std::vector<std::shared_ptr<PendingTask>> dispatch;
+      for (auto &queue : queues_) {
+        CoreQueue &core_queue = queue.second;
+        while (!core_queue.pending.empty() &&
+               core_queue.inflight < max_inflight_per_core_) {
+          auto first = core_queue.pending.begin();
+          RemovePendingId(*first);
+          dispatch.push_back(*first);
+          core_queue.pending.erase(first);
+          core_queue.inflight++;
+        }
+      }
+      bool drop_expired = drop_expired_;
+      lck.unlock();
+
+      for (auto &task : finished) {
+        hbDNNReleaseTask(task->task_handle);
+        task->task_handle = nullptr;
+        Finish(task);
+      }
+      for (auto &task : canceled) {
+        Finish(task);
+      }
+
+      std::vector<std::shared_ptr<PendingTask>> rejected;
+      for (auto &task : dispatch) {
+        if (drop_expired && Expired(task)) {
+          task->status = DNN_TIMEOUT;
+          task->dropped = true;
+          rejected.push_back(task);
+          continue;
+        }
+        int32_t ret = Dispatch(task);
+        if (ret != DNN_SUCCESS) {
+          task->status = ret;
+          rejected.push_back(task);
+        }
+      }
+      for (auto &task : rejected) {
+        Finish(task);
+      }
+
+      lck.lock();
+      for (auto &task : rejected) {
+        queues_[task->ctrl_param.bpuCoreId].inflight--;
+      }
+    }
+  }
+
+  static bool Expired(std::shared_ptr<PendingTask> const &task) {
+    int32_t estimate_latency = 0;
+    if (hbDNNGetEstimateLatency(&estimate_latency, task->dnn_handle) !=
+        DNN_SUCCESS) {
+      estimate_latency = 0;
+    }
+    return NowUs() + estimate_latency > task->deadline;
+  }
+
+  int32_t Dispatch(std::shared_ptr<PendingTask> const &task) {
+    hbDNNTensor *output = task->outputs.data();
+    hbDNNTaskHandle_t task_handle = nullptr;
+    task->dispatch_time = NowUs();
+    int32_t ret = hbDNNInfer(&task_handle,
+                             &output,
+                             task->inputs.data(),
+                             task->dnn_handle,
+                             &task->ctrl_param);
+    if (ret != DNN_SUCCESS) {
+      task->dispatch_time = 0;
+      return ret;
+    }
+    task->task_handle = task_handle;
+    {
+      std::lock_guard<std::mutex> lck{mutex_};
+      running_[task_handle] = task;
+    }
+    ret = hbDNNSetTaskDoneCb(task_handle, &DeadlineScheduler::OnTaskDone,
+                             task.get());
+    if (ret != DNN_SUCCESS) {
+      // never wait here, it would stall dispatch to every core
+      {
+        std::lock_guard<std::mutex> lck{mutex_};
+        running_.erase(task_handle);
+      }
+      hbDNNReleaseTask(task_handle);
+      task->task_handle = nullptr;
+      task->dispatch_time = 0;
+      return ret;
+    }
+    return DNN_SUCCESS;
+  }
+
+  void Finish(std::shared_ptr<PendingTask> const &task) {
+    DeadlineTaskResult result;
+    result.custom_id = task->ctrl_param.customId;
+    result.status = task->status;
+    result.bpu_core_id = task->ctrl_param.bpuCoreId;
+    result.deadline = task->deadline;
+    result.submit_time = task->submit_time;
+    result.dispatch_time = task->dispatch_time;
+    result.done_time = NowUs();
+    // canceled, dropped and rejected tasks never ran
+    result.deadline_missed =
+        result.dispatch_time > 0 && result.done_time > task->deadline;
+    std::shared_ptr<TaskTimeline> timeline;
+    {
+      std::lock_guard<std::mutex> lck{mutex_};
+      timeline = timeline_;
+      if (task->canceled) {
+        statistics_.canceled++;
+      } else if (task->dropped) {
+        statistics_.dropped++;
+      } else if (task->status != DNN_SUCCESS) {
+        statistics_.failed++;
+      } else {
+        statistics_.completed++;
+      }
+      if (result.deadline_missed) {
+        statistics_.deadline_missed++;
+      }
+    }
+    if (timeline) {
+      int64_t queued_end =
+          result.dispatch_time > 0 ? result.dispatch_time : result.done_time;
+      timeline->Record(TimelineEvent{"queued",
+                                     "queue",
+                                     result.bpu_core_id,
+                                     result.custom_id,
+                                     result.submit_time,
+                                     queued_end});
+      if (result.dispatch_time > 0) {
+        timeline->Record(TimelineEvent{"running",
+                                       "bpu",
+                                       result.bpu_core_id,
+                                       result.custom_id,
+                                       result.dispatch_time,
+                                       result.done_time});
+      }
+    }
+    if (task->callback) {
+      task->callback(result);
+    }
+  }
+
+ private:
+  int32_t max_inflight_per_core_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<int32_t, CoreQueue> queues_;
+  std::map<hbDNNTaskHandle_t, std::shared_ptr<PendingTask>> running_;
+  std::multimap<int64_t, std::shared_ptr<PendingTask>> pending_ids_;
+  std::vector<std::shared_ptr<PendingTask>> finished_;
+  std::vector<std::shared_ptr<PendingTask>> canceled_;
+  Statistics statistics_;
+  std::shared_ptr<TaskTimeline> timeline_;
+  uint64_t sequence_{0U};
+  bool drop_expired_{false};
+  bool stopping_{false};
+  std::thread worker_;
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_DEADLINE_SCHEDULER_H_
@@ -0,0 +1,631 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_DEQUANTIZE_H_
+#define _EASY_DNN_DEQUANTIZE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+#endif
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/byte_swap.h"
+#include "easy_dnn/layout_convert.h"
+#include "easy_dnn/status.h"
+#include "easy_dnn/thread_pool.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Dequantization of BPU output tensors to dense float data.
+ * `ToFloat` reads the aligned buffer once: padding is skipped by
+ *    `properties.stride`, values are dequantized by `properties.quantiType`
+ *    along `properties.quantizeAxis`, and a 4D tensor is written in the
+ *    requested layout, replacing `hbDNNRemovePadding`, `hbDNNConvertLayout`
+ *    and `hbDNNUnquantizeByScale` passes.
+ * S8, U8, S16, U16, S32 and F32 data is supported. Scales, shifts and zero
+ *    points are either per tensor (length 1) or per `quantizeAxis`, values
+ *    are `(x - zero_point) * scale` or `x / 2^shift`.
+ * With `convert_endianness` the bytes of each element are reversed right
+ *    after loading, replacing an `hbDNNConvertEndianness` pass.
+ */
+class Dequantizer {
+ public:
+  /**
+   * Dequantize a tensor to dense float data
+   * @param[out] output, element count of `properties.validShape`
+   * @param[in] output_layout, `HB_DNN_LAYOUT_NHWC` or `HB_DNN_LAYOUT_NCHW`
+   *    for 4D tensors, `HB_DNN_LAYOUT_NONE` keeps the tensor layout
+   * @param[in] tensor, invalidate cache before call if memory is cached
+   * @param[in] convert_endianness, reverse bytes of each tensor element
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t ToFloat(float *output,
+                         int32_t output_layout,
+                         hbDNNTensor const &tensor,
+                         bool convert_endianness = false) {
+    return Convert(output, output_layout, tensor, convert_endianness);
+  }
+
+  /**
+   * Dequantize a tensor to dense IEEE half precision data
+   * @param[out] output, bits of float16 values
+   * @param[in] output_layout, same as `ToFloat`
+   * @param[in] tensor, invalidate cache before call if memory is cached
+   * @param[in] convert_endianness, reverse bytes of each tensor element
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t ToFloat16(uint16_t *output,
+                           int32_t output_layout,
+                           hbDNNTensor const &tensor,
+                           bool convert_endianness = false) {
+    return Convert(output, output_layout, tensor, convert_endianness);
+  }
+
+  /**
+   * Dequantize dense data by scale, like `hbDNNUnquantizeByScale` but with
+   *    zero points and any quantize axis
+   * @param[out] output
+   * @param[in] input
+   * @param[in] data_type
+   * @param[in] shape
+   * @param[in] scale
+   * @param[in] quantize_axis, used if scale or zero point is per axis
+   * @param[in] convert_endianness, reverse bytes of each input element
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t UnquantizeByScale(float *output,
+                                   void const *input,
+                                   int32_t data_type,
+                                   hbDNNTensorShape const &shape,
+                                   hbDNNQuantiScale const &scale,
+                                   int32_t quantize_axis,
+                                   bool convert_endianness = false) {
+    hbDNNTensor tensor;
+    memset(&tensor, 0, sizeof(tensor));
+    tensor.sysMem[0].virAddr = const_cast<void *>(input);
+    hbDNNTensorProperties &properties = tensor.properties;
+    properties.validShape = shape;
+    properties.alignedShape = shape;
+    properties.tensorLayout = HB_DNN_LAYOUT_NONE;
+    properties.tensorType = data_type;
+    properties.quantiType = SCALE;
+    properties.scale = scale;
+    properties.quantizeAxis = quantize_axis;
+    int32_t stride = LayoutConvert::ElementSize(data_type);
+    for (int32_t i = shape.numDimensions - 1; i >= 0 && stride > 0; i--) {
+      properties.stride[i] = stride;
+      stride *= shape.dimensionSize[i];
+    }
+    return Convert(output, HB_DNN_LAYOUT_NONE, tensor, convert_endianness);
+  }
+
+  /**
+   * Convert float to IEEE half precision, round to nearest even
+   * @param[in] value
+   * @return bits of float16 value
+   */
+  static uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000U;
+    bits &= 0x7FFFFFFFU;
+    uint16_t half;
+    if (bits >= 0x47800000U) {
+      // overflow to inf, nan stays nan
+      half = bits > 0x7F800000U ? 0x7E00U : 0x7C00U;
+    } else if (bits < 0x38800000U) {
+      // subnormal, let the float adder round the mantissa
+      float magic;
+      uint32_t magic_bits = 126U << 23;
+      memcpy(&magic, &magic_bits, sizeof(magic));
+      float abs_value;
+      memcpy(&abs_value, &bits, sizeof(abs_value));
+      abs_value += magic;
+      memcpy(&bits, &abs_value, sizeof(bits));
+      half = static_cast<uint16_t>(bits - magic_bits);
+    } else {
+      uint32_t odd = (bits >> 13) & 1U;
+      bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFU + odd;
+      half = static_cast<uint16_t>(bits >> 13);
+    }
+    return static_cast<uint16_t>(half | sign);
+  }
+
+ private:
+  // tensors with less elements are dequantized on the calling thread
+  static constexpr size_t kParallelElements = 64U << 10;
+
+  struct Rows {
+    uint8_t const *data;
+    int32_t type;
+    int32_t dim_num;
+    int32_t const *valid;
+    int32_t const *stride;
+    size_t row_count;
+    size_t row_length;
+    int32_t axis;
+    bool swap;
+    // value is x * scales[i] + offsets[i], offsets are -zero_point * scale
+    std::vector<float> scales;
+    std::vector<float> offsets;
+  };
+
+  template <typename Out>
+  static int32_t Convert(Out *output,
+                         int32_t output_layout,
+                         hbDNNTensor const &tensor,
+                         bool convert_endianness) {
+    hbDNNTensorProperties const &properties = tensor.properties;
+    int32_t const *valid = properties.validShape.dimensionSize;
+    int32_t dim_num = properties.validShape.numDimensions;
+    int32_t element_size = LayoutConvert::ElementSize(properties.tensorType);
+    if (output == nullptr || tensor.sysMem[0].virAddr == nullptr ||
+        dim_num <= 0 || dim_num > HB_DNN_TENSOR_MAX_DIMENSIONS ||
+        !IsSupportedType(properties.tensorType)) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    for (int32_t i = 0; i < dim_num; i++) {
+      if (valid[i] <= 0 || properties.stride[i] < element_size) {
+        return DNN_INVALID_ARGUMENT;
+      }
+    }
+    bool transpose = output_layout != HB_DNN_LAYOUT_NONE &&
+                     output_layout != properties.tensorLayout;
+    if (transpose &&
+        (dim_num != 4 ||
+         (output_layout != HB_DNN_LAYOUT_NHWC &&
+          output_layout != HB_DNN_LAYOUT_NCHW) ||
+         (properties.tensorLayout != HB_DNN_LAYOUT_NHWC &&
+          properties.tensorLayout != HB_DNN_LAYOUT_NCHW))) {
+      return DNN_INVALID_ARGUMENT;
+    }
+
+    Rows rows;
+    int32_t ret = InitRows(rows, tensor);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    rows.swap = convert_endianness;
+    if (!transpose) {
+      size_t count = rows.row_count;
+      Parallel(count, rows.row_length, [&rows, output](size_t b, size_t e) {
+        std::vector<float> buffer;
+        int32_t index[HB_DNN_TENSOR_MAX_DIMENSIONS];
+        for (size_t r = b; r < e; r++) {
+          Out *dst = output + r * rows.row_length;
+          float *row = RowBuffer(dst, buffer, rows.row_length);
+          RowIndex(index, rows, r);
+          RunRow(row, rows, index);
+          Store(dst, row, rows.row_length);
+        }
+      });
+      return DNN_SUCCESS;
+    }
+
+    // one unit is a (n, h) slice, rows of the slice are dequantized into a
+    //    small dense block, then transposed into place
+    bool nhwc = properties.tensorLayout == HB_DNN_LAYOUT_NHWC;
+    size_t n = static_cast<size_t>(valid[0]);
+    size_t h = static_cast<size_t>(nhwc ? valid[1] : valid[2]);
+    size_t w = static_cast<size_t>(nhwc ? valid[2] : valid[3]);
+    size_t c = static_cast<size_t>(nhwc ? valid[3] : valid[1]);
+    size_t block_rows = nhwc ? w : c;
+    size_t slice = w * c;
+    Parallel(n * h, slice, [&](size_t b, size_t e) {
+      std::vector<float> buffer;
+      std::vector<Out> converted(slice);
+      float *block = RowBuffer(converted.data(), buffer, slice);
+      int32_t index[HB_DNN_TENSOR_MAX_DIMENSIONS] = {0};
+      for (size_t u = b; u < e; u++) {
+        size_t ni = u / h;
+        size_t hi = u % h;
+        index[0] = static_cast<int32_t>(ni);
+        index[nhwc ? 1 : 2] = static_cast<int32_t>(hi);
+        for (size_t i = 0U; i < block_rows; i++) {
+          // NHWC rows are indexed by w, NCHW rows by c
+          index[nhwc ? 2 : 1] = static_cast<int32_t>(i);
+          RunRow(block + i * rows.row_length, rows, index);
+        }
+        Store(converted.data(), block, slice);
+        if (nhwc) {
+          LayoutConvert::Transpose(output + (ni * c * h + hi) * w,
+                                   h * w,
+                                   converted.data(),
+                                   c,
+                                   w,
+                                   c,
+                                   sizeof(Out));
+        } else {
+          LayoutConvert::Transpose(output + (ni * h + hi) * w * c,
+                                   c,
+                                   converted.data(),
+                                   w,
+                                   c,
+                                   w,
+                                   sizeof(Out));
+        }
+      }
+    });
+    return DNN_SUCCESS;
+  }
+
+  static bool IsSupportedType(int32_t type) {
+    return type == HB_DNN_TENSOR_TYPE_S8 || type == HB_DNN_TENSOR_TYPE_U8 ||
+           type == HB_DNN_TENSOR_TYPE_S16 || type == HB_DNN_TENSOR_TYPE_U16 ||
+           type == HB_DNN_TENSOR_TYPE_S32 || type == HB_DNN_TENSOR_TYPE_F32;
+  }
+
+  static int32_t InitRows(Rows &rows, hbDNNTensor const &tensor) {
+    hbDNNTensorProperties const &properties = tensor.properties;
+    rows.data = static_cast<uint8_t const *>(tensor.sysMem[0].virAddr);
+    rows.type = properties.tensorType;
+    rows.dim_num = properties.validShape.numDimensions;
+    rows.valid = properties.validShape.dimensionSize;
+    rows.stride = properties.stride;
+    rows.row_length = static_cast<size_t>(rows.valid[rows.dim_num - 1]);
+    rows.row_count = 1U;
+    for (int32_t i = 0; i + 1 < rows.dim_num; i++) {
+      rows.row_count *= static_cast<size_t>(rows.valid[i]);
+    }
+    rows.axis = properties.quantizeAxis;
+    if (properties.quantiType == NONE) {
+      rows.scales.assign(1U, 1.0F);
+      rows.offsets.assign(1U, 0.0F);
+      return DNN_SUCCESS;
+    }
+    bool scale_type = properties.quantiType == SCALE;
+    int32_t scale_len =
+        scale_type ? properties.scale.scaleLen : properties.shift.shiftLen;
+    int32_t zero_len = scale_type ? properties.scale.zeroPointLen : 0;
+    int32_t len = std::max(scale_len, zero_len);
+    if (scale_len <= 0 || (scale_len != 1 && scale_len != len) ||
+        (zero_len > 1 && zero_len != len) ||
+        (len > 1 && (rows.axis < 0 || rows.axis >= rows.dim_num ||
+                     len < rows.valid[rows.axis]))) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    rows.scales.resize(static_cast<size_t>(len));
+    rows.offsets.resize(static_cast<size_t>(len));
+    for (int32_t i = 0; i < len; i++) {
+      int32_t si = scale_len == 1 ? 0 : i;
+      float scale = scale_type
+                        ? properties.scale.scaleData[si]
+                        : std::ldexp(1.0F, -properties.shift.shiftData[si]);
+      float zero_point =
+          zero_len > 0
+              ? static_cast<float>(
+                    properties.scale.zeroPointData[zero_len == 1 ? 0 : i])
+              : 0.0F;
+      rows.scales[i] = scale;
+      rows.offsets[i] = -zero_point * scale;
+    }
+    return DNN_SUCCESS;
+  }
+
+  template <typename Fn>
+  static void Parallel(size_t count, size_t unit_elements, Fn const &fn) {
+    if (count * unit_elements < kParallelElements) {
+      fn(0U, count);
+      return;
+    }
+    ThreadPool::GetInstance().ParallelFor(
+        count, kParallelElements / 4U / unit_elements + 1U, fn);
+  }
+
+  static void RowIndex(int32_t *index, Rows const &rows, size_t row) {
+    for (int32_t i = rows.dim_num - 2; i >= 0; i--) {
+      index[i] = static_cast<int32_t>(row % rows.valid[i]);
+      row /= rows.valid[i];
+    }
+  }
+
+  // float rows are dequantized in place, half rows through a buffer
+  static float *RowBuffer(float *dst, std::vector<float> &, size_t) {
+    return dst;
+  }
+
+  static float *RowBuffer(uint16_t *,
+                          std::vector<float> &buffer,
+                          size_t count) {
+    buffer.resize(count);
+    return buffer.data();
+  }
+
+  static float *Store(float *dst, float const *, size_t) { return dst; }
+
+  static uint16_t *Store(uint16_t *dst, float const *src, size_t count) {
+    size_t i = 0U;
+#if defined(__aarch64__)
+    for (; i + 4U <= count; i += 4U) {
+      vst1_u16(dst + i,
+               vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    }
+#elif defined(__SSE2__) && defined(__F16C__)
+    for (; i + 4U <= count; i += 4U) {
+      _mm_storel_epi64(
+          reinterpret_cast<__m128i *>(dst + i),
+          _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+    for (; i < count; i++) {
+      dst[i] = FloatToHalf(src[i]);
+    }
+    return dst;
+  }
+
+  static void RunRow(float *dst, Rows const &rows, int32_t const *index) {
+    size_t offset = 0U;
+    for (int32_t i = 0; i + 1 < rows.dim_num; i++) {
+      offset += static_cast<size_t>(index[i]) * rows.stride[i];
+    }
+    uint8_t const *src = rows.data + offset;
+    size_t step = static_cast<size_t>(rows.stride[rows.dim_num - 1]);
+    Factor factor{nullptr, nullptr, rows.scales[0], rows.offsets[0]};
+    if (rows.scales.size() > 1U) {
+      if (rows.axis == rows.dim_num - 1) {
+        factor.scales = rows.scales.data();
+        factor.offsets = rows.offsets.data();
+      } else {
+        factor.scale = rows.scales[index[rows.axis]];
+        factor.offset = rows.offsets[index[rows.axis]];
+      }
+    }
+    switch (rows.type) {
+      case HB_DNN_TENSOR_TYPE_S8:
+        Row<int8_t>(dst, src, step, rows.row_length, rows.swap, factor);
+        break;
+      case HB_DNN_TENSOR_TYPE_U8:
+        Row<uint8_t>(dst, src, step, rows.row_length, rows.swap, factor);
+        break;
+      case HB_DNN_TENSOR_TYPE_S16:
+        Row<int16_t>(dst, src, step, rows.row_length, rows.swap, factor);
+        break;
+      case HB_DNN_TENSOR_TYPE_U16:
+        Row<uint16_t>(dst, src, step, rows.row_length, rows.swap, factor);
+        break;
+      case HB_DNN_TENSOR_TYPE_S32:
+        Row<int32_t>(dst, src, step, rows.row_length, rows.swap, factor);
+        break;
+      default:
+        Row<float>(dst, src, step, rows.row_length, rows.swap, factor);
+        break;
+    }
+  }
+
+  // per element arrays if not null, otherwise one value for the row
+  struct Factor {
+    float const *scales;
+    float const *offsets;
+    float scale;
+    float offset;
+  };
+
+  template <typename T>
+  static void Row(float *dst,
+                  uint8_t const *bytes,
+                  size_t step,
+                  size_t count,
+                  bool swap,
+                  Factor const &factor) {
+    size_t i = 0U;
+    if (step == sizeof(T)) {
+      // no vector loads if the innermost dimension is padded per element
+      i = Row8(dst, reinterpret_cast<T const *>(bytes), count, swap, factor);
+    }
+    for (; i < count; i++) {
+      T value;
+      memcpy(&value, bytes + i * step, sizeof(T));
+      if (swap) {
+        value = ByteSwap::Swap(value);
+      }
+      float scale = factor.scales ? factor.scales[i] : factor.scale;
+      float offset = factor.offsets ? factor.offsets[i] : factor.offset;
+      dst[i] = static_cast<float>(value) * scale + offset;
+    }
+  }
+
+  // dequantize groups of 8 elements, return count of elements done
+  template <typename T>
+  static size_t Row8(float *dst,
+                     T const *src,
+                     size_t count,
+                     bool swap,
+                     Factor const &factor) {
+    float const *scales = factor.scales;
+    float const *offsets = factor.offsets;
+    size_t i = 0U;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t scale = vdupq_n_f32(factor.scale);
+    float32x4_t offset = vdupq_n_f32(factor.offset);
+    for (; i + 8U <= count; i += 8U) {
+      float32x4_t lo, hi;
+      Load8(src + i, swap, lo, hi);
+      if (scales != nullptr) {
+        lo = vmlaq_f32(vld1q_f32(offsets + i), lo, vld1q_f32(scales + i));
+        hi = vmlaq_f32(
+            vld1q_f32(offsets + i + 4U), hi, vld1q_f32(scales + i + 4U));
+      } else {
+        lo = vmlaq_f32(offset, lo, scale);
+        hi = vmlaq_f32(offset, hi, scale);
+      }
+      vst1q_f32(dst + i, lo);
+      vst1q_f32(dst + i + 4U, hi);
+    }
+#elif defined(__SSE2__)
+    __m128 scale = _mm_set1_ps(factor.scale);
+    __m128 offset = _mm_set1_ps(factor.offset);
+    for (; i + 8U <= count; i += 8U) {
+      __m128 lo, hi;
+      Load8(src + i, swap, lo, hi);
+      if (scales != nullptr) {
+        lo = _mm_add_ps(_mm_mul_ps(lo, _mm_loadu_ps(scales + i)),
+                        _mm_loadu_ps(offsets + i));
+        hi = _mm_add_ps(_mm_mul_ps(hi, _mm_loadu_ps(scales + i + 4U)),
+                        _mm_loadu_ps(offsets + i + 4U));
+      } else {
+        lo = _mm_add_ps(_mm_mul_ps(lo, scale), offset);
+        hi = _mm_add_ps(_mm_mul_ps(hi, scale), offset);
+      }
+      _mm_storeu_ps(dst + i, lo);
+      _mm_storeu_ps(dst + i + 4U, hi);
+    }
+#else
+    (void)dst;
+    (void)src;
+    (void)count;
+    (void)swap;
+    (void)scales;
+    (void)offsets;
+#endif
+    return i;
+  }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  static void Load8(int8_t const *src,
+                    bool,
+                    float32x4_t &lo,
+                    float32x4_t &hi) {
+    int16x8_t value = vmovl_s8(vld1_s8(src));
+    lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(value)));
+    hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(value)));
+  }
+
+  static void Load8(uint8_t const *src,
+                    bool,
+                    float32x4_t &lo,
+                    float32x4_t &hi) {
+    uint16x8_t value = vmovl_u8(vld1_u8(src));
+    lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(value)));
+    hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(value)));
+  }
+
+  static void Load8(int16_t const *src,
+                    bool swap,
+                    float32x4_t &lo,
+                    float32x4_t &hi) {
+    int16x8_t value = vreinterpretq_s16_u8(Load16(src, swap));
+    lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(value)));
+    hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(value)));
+  }
+
+  static void Load8(uint16_t const *src,
+                    bool swap,
+                    float32x4_t &lo,
+                    float32x4_t &hi) {
+    uint16x8_t value = vreinterpretq_u16_u8(Load16(src, swap));
+    lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(value)));
+    hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(value)));
+  }
+
+  static void Load8(int32_t const *src,
+                    bool swap,
+                    float32x4_t &lo,
+                    float32x4_t &hi) {
+    lo = vcvtq_f32_s32(vreinterpretq_s32_u8(Load16(src, swap)));
+    hi = vcvtq_f32_s32(vreinterpretq_s32_u8(Load16(src + 4, swap)));
+  }
+
+  static void Load8(float const *src,
+                    bool swap,
+                    float32x4_t &lo,
+                    float32x4_t &hi) {
+    lo = vreinterpretq_f32_u8(Load16(src, swap));
+    hi = vreinterpretq_f32_u8(Load16(src + 4, swap));
+  }
+
+  // load 16 bytes, reversing the bytes of each element if asked
+  template <typename T>
+  static uint8x16_t Load16(T const *src, bool swap) {
+    uint8x16_t value = vld1q_u8(reinterpret_cast<uint8_t const *>(src));
+    if (!swap) {
+      return value;
+    }
+    return sizeof(T) == 2U ? ByteSwap::Vector16(value)
+                           : ByteSwap::Vector32(value);
+  }
+#elif defined(__SSE2__)
+  static void Load8(int8_t const *src, bool, __m128 &lo, __m128 &hi) {
+    __m128i value =
+        _mm_loadl_epi64(reinterpret_cast<__m128i const *>(src));
+    // sign extend by unpacking into the high half and shifting back
+    value = _mm_srai_epi16(_mm_unpacklo_epi8(value, value), 8);
+    Widen(value, lo, hi);
+  }
+
+  static void Load8(uint8_t const *src, bool, __m128 &lo, __m128 &hi) {
+    __m128i value =
+        _mm_loadl_epi64(reinterpret_cast<__m128i const *>(src));
+    __m128i zero = _mm_setzero_si128();
+    value = _mm_unpacklo_epi8(value, zero);
+    lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, zero));
+    hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(value, zero));
+  }
+
+  static void Load8(int16_t const *src, bool swap, __m128 &lo, __m128 &hi) {
+    Widen(Load16(src, swap), lo, hi);
+  }
+
+  static void Load8(uint16_t const *src, bool swap, __m128 &lo, __m128 &hi) {
+    __m128i value = Load16(src, swap);
+    __m128i zero = _mm_setzero_si128();
+    lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, zero));
+    hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(value, zero));
+  }
+
+  static void Load8(int32_t const *src, bool swap, __m128 &lo, __m128 &hi) {
+    lo = _mm_cvtepi32_ps(Load16(src, swap));
+    hi = _mm_cvtepi32_ps(Load16(src + 4, swap));
+  }
+
+  static void Load8(float const *src, bool swap, __m128 &lo, __m128 &hi) {
+    lo = _mm_castsi128_ps(Load16(src, swap));
+    hi = _mm_castsi128_ps(Load16(src + 4, swap));
+  }
+
+  // load 16 bytes, reversing the bytes of each element if asked
+  template <typename T>
+  static __m128i Load16(T const *src, bool swap) {
+    __m128i value = ByteSwap::Load(reinterpret_cast<uint8_t const *>(src));
+    if (!swap) {
+      return value;
+    }
+    return sizeof(T) == 2U ? ByteSwap::Vector16(value)
+                           : ByteSwap::Vector32(value);
+  }
+
+  // sign extend 8 int16 values to float
+  static void Widen(__m128i value, __m128 &lo, __m128 &hi) {
+    lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16));
+    hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16));
+  }
+#endif
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_DEQUANTIZE_H_
@@ -0,0 +1,134 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_DMA_BUF_MEM_H_
+#define _EASY_DNN_DMA_BUF_MEM_H_
+
+#include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "dnn/hb_sys.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * System memory imported from a dma-buf fd, e.g. a V4L2 or ISP frame, so
+ *    the frame can be used as `hbDNNTensor::sysMem` without a copy.
+ * The physical address is not derivable from the fd in user space, it is
+ *    taken from the producer of the buffer, e.g. the `paddr` of a VIO
+ *    buffer. The fd is duplicated and mapped, and the memory is registered
+ *    by `hbSysRegisterMem`; all of it is undone on destruction.
+ */
+class DmaBufMem {
+ public:
+  /**
+   * Import a dma-buf
+   * @param[out] mem
+   * @param[in] fd, dma-buf fd, still owned by the caller
+   * @param[in] phy_addr, physical address of the buffer
+   * @param[in] size, byte size, 0 means the whole dma-buf
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Import(std::shared_ptr<DmaBufMem> &mem,
+                        int32_t fd,
+                        uint64_t phy_addr,
+                        uint32_t size = 0U) {
+    if (fd < 0 || phy_addr == 0U) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    off_t buf_size = lseek(fd, 0, SEEK_END);
+    if (buf_size <= 0 || static_cast<uint64_t>(buf_size) > UINT32_MAX ||
+        size > static_cast<uint64_t>(buf_size)) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    if (size == 0U) {
+      size = static_cast<uint32_t>(buf_size);
+    }
+    std::shared_ptr<DmaBufMem> dma_buf_mem{new DmaBufMem()};
+    dma_buf_mem->fd_ = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dma_buf_mem->fd_ < 0) {
+      return DNN_API_USE_ERROR;
+    }
+    void *addr = mmap(
+        nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, dma_buf_mem->fd_, 0);
+    if (addr == MAP_FAILED) {
+      return DNN_OUT_OF_MEMORY;
+    }
+    dma_buf_mem->sys_mem_.phyAddr = phy_addr;
+    dma_buf_mem->sys_mem_.virAddr = addr;
+    dma_buf_mem->sys_mem_.memSize = size;
+    int32_t ret = hbSysRegisterMem(&dma_buf_mem->sys_mem_);
+    if (ret != HB_SYS_SUCCESS) {
+      return ret;
+    }
+    dma_buf_mem->registered_ = true;
+    mem = dma_buf_mem;
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Get the imported memory
+   * @return system memory, usable as `hbDNNTensor::sysMem`
+   */
+  hbSysMem &GetSysMem() { return sys_mem_; }
+
+  /**
+   * Bracket CPU access, so the exporter keeps its caches coherent
+   * @param[in] begin, true before CPU access, false after it
+   * @param[in] write, CPU writes the buffer, otherwise only reads it
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t SyncCpuAccess(bool begin, bool write) {
+    struct dma_buf_sync sync {};
+    sync.flags = (begin ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END) |
+                 (write ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ);
+    return ioctl(fd_, DMA_BUF_IOCTL_SYNC, &sync) == 0 ? DNN_SUCCESS
+                                                      : DNN_API_USE_ERROR;
+  }
+
+  DmaBufMem(DmaBufMem const &) = delete;
+  DmaBufMem &operator=(DmaBufMem const &) = delete;
+
+  ~DmaBufMem() {
+    if (registered_) {
+      hbSysUnregisterMem(&sys_mem_);
+    }
+    if (sys_mem_.virAddr != nullptr) {
+      munmap(sys_mem_.virAddr, sys_mem_.memSize);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+ private:
+  DmaBufMem() = default;
+
+ private:
+  int32_t fd_{-1};
+  bool registered_{false};
+  hbSysMem sys_mem_{0U, nullptr, 0U};
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_DMA_BUF_MEM_H_
@@ -0,0 +1,665 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_IMAGE_CONVERT_H_
+#define _EASY_DNN_IMAGE_CONVERT_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/status.h"
+#include "easy_dnn/thread_pool.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Where the image was placed in the tensor
+ * Tensor pixel (u, v) inside the box shows image pixel
+ *    ((u - x) / scale_x, (v - y) / scale_y).
+ */
+struct LetterboxInfo {
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+  float scale_x;
+  float scale_y;
+};
+
+/**
+ * Image preprocessing for `HB_DNN_IMG_TYPE_NV12` and
+ *    `HB_DNN_IMG_TYPE_NV12_SEPARATE` model inputs.
+ * `ToNv12` resizes a packed BGR/RGB image (e.g. the data of a `cv::Mat`)
+ *    and converts it to NV12 in one pass, writing the planes of the input
+ *    tensor by their stride. It replaces `cv::resize`, `cv::cvtColor` to
+ *    I420, interleaving UV and copying into `hbSysMem`.
+ * Resizing is bilinear with half pixel centers like `cv::INTER_LINEAR`,
+ *    colors are converted with BT.601 limited range coefficients like
+ *    `cv::COLOR_BGR2YUV_I420`, chroma is the mean of each 2x2 block.
+ *    Rows are split across `ThreadPool`, vertical interpolation and color
+ *    conversion use NEON (SSE2 on x86).
+ * `ResizeNv12` is the CPU counterpart of `hbDNNResize` for Y and NV12
+ *    images, built on the same kernels.
+ * Y rows are `alignedShape` width bytes apart, the UV plane follows the
+ *    Y plane of `alignedShape` height for NV12 and is `sysMem[1]` for
+ *    NV12_SEPARATE.
+ */
+class ImageConvert {
+ public:
+  typedef enum {
+    // scale width and height independently to fill the tensor
+    RESIZE_STRETCH = 0,
+    // keep aspect ratio, center and pad the remaining border
+    RESIZE_LETTERBOX,
+  } ResizeMode;
+
+  /**
+   * Resize and convert a BGR or RGB image into an NV12 input tensor
+   * @param[inout] tensor, even valid width and height, clean cache after
+   *    call if memory is cached
+   * @param[in] image, packed 3 channel pixels
+   * @param[in] image_type, `HB_DNN_IMG_TYPE_BGR` or `HB_DNN_IMG_TYPE_RGB`
+   * @param[in] width, image width
+   * @param[in] height, image height
+   * @param[in] stride, bytes between image rows
+   * @param[in] resize_mode
+   * @param[in] pad_value, gray level of the letterbox border
+   * @param[out] info, placement of the image if not null
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t ToNv12(hbDNNTensor &tensor,
+                        uint8_t const *image,
+                        int32_t image_type,
+                        int32_t width,
+                        int32_t height,
+                        int32_t stride,
+                        ResizeMode resize_mode,
+                        uint8_t pad_value = 114U,
+                        LetterboxInfo *info = nullptr) {
+    Nv12Planes planes;
+    int32_t ret = GetNv12Planes(planes, tensor);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    if (planes.uv == nullptr || image == nullptr || width <= 0 ||
+        height <= 0 ||
+        stride < width * 3 ||
+        (image_type != HB_DNN_IMG_TYPE_BGR &&
+         image_type != HB_DNN_IMG_TYPE_RGB)) {
+      return DNN_INVALID_ARGUMENT;
+    }
+
+    LetterboxInfo box{0, 0, planes.width, planes.height, 0.0F, 0.0F};
+    if (resize_mode == RESIZE_LETTERBOX) {
+      float scale = std::min(
+          static_cast<float>(planes.width) / static_cast<float>(width),
+          static_cast<float>(planes.height) / static_cast<float>(height));
+      // even placement, so chroma samples never mix image and border
+      box.width = std::min(
+          planes.width,
+          std::max(2, EvenRound(static_cast<float>(width) * scale)));
+      box.height = std::min(
+          planes.height,
+          std::max(2, EvenRound(static_cast<float>(height) * scale)));
+      box.x = (planes.width - box.width) / 2 & ~1;
+      box.y = (planes.height - box.height) / 2 & ~1;
+    }
+    box.scale_x =
+        static_cast<float>(box.width) / static_cast<float>(width);
+    box.scale_y =
+        static_cast<float>(box.height) / static_cast<float>(height);
+    if (info != nullptr) {
+      *info = box;
+    }
+
+    float gray = static_cast<float>(pad_value);
+    FillBorder(planes, box, ToY(gray, gray, gray));
+
+    Axis x_axis;
+    Axis y_axis;
+    MakeAxis(x_axis, width, box.width);
+    MakeAxis(y_axis, height, box.height);
+    Source source{image,
+                  static_cast<size_t>(stride),
+                  3U,
+                  {image_type == HB_DNN_IMG_TYPE_BGR ? 2U : 0U,
+                   1U,
+                   image_type == HB_DNN_IMG_TYPE_BGR ? 0U : 2U}};
+    size_t pair_count = static_cast<size_t>(box.height) / 2U;
+    size_t pixels = static_cast<size_t>(box.width) * 2U;
+    Parallel(pair_count, pixels, [&](size_t b, size_t e) {
+      size_t w = static_cast<size_t>(box.width);
+      RowCache cache(3U, w);
+      std::vector<float> buffer(6U * w);
+      float *rows[2][3];
+      for (size_t i = 0U; i < 2U; i++) {
+        for (size_t c = 0U; c < 3U; c++) {
+          rows[i][c] = buffer.data() + (i * 3U + c) * w;
+        }
+      }
+      for (size_t pair = b; pair < e; pair++) {
+        for (size_t i = 0U; i < 2U; i++) {
+          size_t v = pair * 2U + i;
+          InterpolateRow(rows[i], cache, source, x_axis, y_axis, v);
+          size_t y = static_cast<size_t>(box.y) + v;
+          StoreY(planes.y + y * planes.stride + box.x,
+                 rows[i][0],
+                 rows[i][1],
+                 rows[i][2],
+                 w);
+        }
+        size_t y = static_cast<size_t>(box.y) / 2U + pair;
+        StoreUv(planes.uv + y * planes.stride + box.x, rows[0], rows[1], w);
+      }
+    });
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Bilinear resize of an roi of a Y, NV12 or NV12_SEPARATE image, same
+   *    result layout as `hbDNNResize` but computed on CPU
+   * @param[inout] output, same image type as input, clean cache after call
+   *    if memory is cached
+   * @param[in] input, invalidate cache before call if memory is cached
+   * @param[in] roi, inclusive coordinates in input, left and top even and
+   *    size even for NV12
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t ResizeNv12(hbDNNTensor &output,
+                            hbDNNTensor const &input,
+                            hbDNNRoi const &roi) {
+    Nv12Planes src;
+    Nv12Planes dst;
+    int32_t ret = GetNv12Planes(src, input);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    ret = GetNv12Planes(dst, output);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    int32_t width = roi.right - roi.left + 1;
+    int32_t height = roi.bottom - roi.top + 1;
+    bool nv12 = src.uv != nullptr;
+    if (nv12 != (dst.uv != nullptr) || roi.left < 0 || roi.top < 0 ||
+        width <= 0 || height <= 0 || roi.right >= src.width ||
+        roi.bottom >= src.height ||
+        (nv12 && (roi.left % 2 != 0 || roi.top % 2 != 0 ||
+                  width % 2 != 0 || height % 2 != 0))) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    size_t left = static_cast<size_t>(roi.left);
+    size_t top = static_cast<size_t>(roi.top);
+    ResizePlane(dst.y,
+                dst.stride,
+                dst.width,
+                dst.height,
+                src.y + top * src.stride + left,
+                src.stride,
+                width,
+                height,
+                1U);
+    if (nv12) {
+      ResizePlane(dst.uv,
+                  dst.stride,
+                  dst.width / 2,
+                  dst.height / 2,
+                  src.uv + top / 2U * src.stride + left,
+                  src.stride,
+                  width / 2,
+                  height / 2,
+                  2U);
+    }
+    return DNN_SUCCESS;
+  }
+
+ private:
+  // images with less pixels are converted on the calling thread
+  static constexpr size_t kParallelPixels = 64U << 10;
+
+  struct Nv12Planes {
+    uint8_t *y;
+    uint8_t *uv;
+    size_t stride;
+    int32_t width;
+    int32_t height;
+  };
+
+  // source positions of each output position along one axis
+  struct Axis {
+    std::vector<int32_t> index0;
+    std::vector<int32_t> index1;
+    std::vector<float> weight;
+  };
+
+  // packed 8 bit image, `order[c]` is the source channel of planar row c
+  struct Source {
+    uint8_t const *data;
+    size_t stride;
+    size_t channels;
+    size_t order[3];
+  };
+
+  // horizontally interpolated rows of the two most recent source rows
+  struct RowCache {
+    RowCache(size_t channel_count, size_t row_width)
+        : channels(channel_count),
+          width(row_width),
+          data(2U * channel_count * row_width) {}
+
+    float *Get(size_t slot, size_t c) {
+      return data.data() + (slot * channels + c) * width;
+    }
+
+    size_t channels;
+    size_t width;
+    int32_t index[2] = {-1, -1};
+    std::vector<float> data;
+  };
+
+  static int32_t EvenRound(float value) {
+    return static_cast<int32_t>(std::lround(value)) & ~1;
+  }
+
+  // `uv` is null for Y images
+  static int32_t GetNv12Planes(Nv12Planes &planes,
+                               hbDNNTensor const &tensor) {
+    hbDNNTensorProperties const &properties = tensor.properties;
+    int32_t type = properties.tensorType;
+    if ((type != HB_DNN_IMG_TYPE_Y && type != HB_DNN_IMG_TYPE_NV12 &&
+         type != HB_DNN_IMG_TYPE_NV12_SEPARATE) ||
+        properties.validShape.numDimensions != 4 ||
+        properties.alignedShape.numDimensions != 4 ||
+        tensor.sysMem[0].virAddr == nullptr ||
+        (type == HB_DNN_IMG_TYPE_NV12_SEPARATE &&
+         tensor.sysMem[1].virAddr == nullptr)) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    bool nhwc = properties.tensorLayout == HB_DNN_LAYOUT_NHWC;
+    int32_t h_dim = nhwc ? 1 : 2;
+    int32_t w_dim = nhwc ? 2 : 3;
+    planes.height = properties.validShape.dimensionSize[h_dim];
+    planes.width = properties.validShape.dimensionSize[w_dim];
+    int32_t aligned_height = properties.alignedShape.dimensionSize[h_dim];
+    int32_t aligned_width = properties.alignedShape.dimensionSize[w_dim];
+    if (planes.width <= 0 || planes.height <= 0 ||
+        aligned_width < planes.width || aligned_height < planes.height ||
+        (type != HB_DNN_IMG_TYPE_Y &&
+         (planes.width % 2 != 0 || planes.height % 2 != 0))) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    planes.stride = static_cast<size_t>(aligned_width);
+    planes.y = static_cast<uint8_t *>(tensor.sysMem[0].virAddr);
+    if (type == HB_DNN_IMG_TYPE_Y) {
+      planes.uv = nullptr;
+    } else if (type == HB_DNN_IMG_TYPE_NV12) {
+      planes.uv =
+          planes.y + planes.stride * static_cast<size_t>(aligned_height);
+    } else {
+      planes.uv = static_cast<uint8_t *>(tensor.sysMem[1].virAddr);
+    }
+    return DNN_SUCCESS;
+  }
+
+  static void MakeAxis(Axis &axis, int32_t src_size, int32_t dst_size) {
+    axis.index0.resize(static_cast<size_t>(dst_size));
+    axis.index1.resize(static_cast<size_t>(dst_size));
+    axis.weight.resize(static_cast<size_t>(dst_size));
+    double scale = static_cast<double>(src_size) / dst_size;
+    for (int32_t i = 0; i < dst_size; i++) {
+      double f = std::max(0.0, (i + 0.5) * scale - 0.5);
+      int32_t index = std::min(static_cast<int32_t>(f), src_size - 1);
+      auto at = static_cast<size_t>(i);
+      axis.index0[at] = index;
+      axis.index1[at] = std::min(index + 1, src_size - 1);
+      axis.weight[at] = static_cast<float>(f - index);
+    }
+  }
+
+  template <typename Fn>
+  static void Parallel(size_t count, size_t unit_pixels, Fn const &fn) {
+    if (count * unit_pixels < kParallelPixels) {
+      fn(0U, count);
+      return;
+    }
+    ThreadPool::GetInstance().ParallelFor(
+        count, kParallelPixels / 4U / unit_pixels + 1U, fn);
+  }
+
+  // bilinear resize of a packed 8 bit plane of 1 or 2 channels
+  static void ResizePlane(uint8_t *dst,
+                          size_t dst_stride,
+                          int32_t dst_width,
+                          int32_t dst_height,
+                          uint8_t const *src,
+                          size_t src_stride,
+                          int32_t src_width,
+                          int32_t src_height,
+                          size_t channels) {
+    Axis x_axis;
+    Axis y_axis;
+    MakeAxis(x_axis, src_width, dst_width);
+    MakeAxis(y_axis, src_height, dst_height);
+    Source source{src, src_stride, channels, {0U, 1U, 2U}};
+    size_t width = static_cast<size_t>(dst_width);
+    Parallel(static_cast<size_t>(dst_height), width, [&](size_t b, size_t e) {
+      RowCache cache(channels, width);
+      std::vector<float> buffer(channels * width);
+      float *rows[2] = {buffer.data(), buffer.data() + width};
+      for (size_t v = b; v < e; v++) {
+        InterpolateRow(rows, cache, source, x_axis, y_axis, v);
+        StorePacked(dst + v * dst_stride, rows, channels, width);
+      }
+    });
+  }
+
+  // Y and UV of the area outside the box
+  static void FillBorder(Nv12Planes const &planes,
+                         LetterboxInfo const &box,
+                         uint8_t y_value) {
+    size_t width = static_cast<size_t>(planes.width);
+    size_t left = static_cast<size_t>(box.x);
+    size_t right_begin = static_cast<size_t>(box.x + box.width);
+    size_t right = width - right_begin;
+    for (int32_t v = 0; v < planes.height; v++) {
+      uint8_t *y = planes.y + static_cast<size_t>(v) * planes.stride;
+      uint8_t *uv = planes.uv + static_cast<size_t>(v / 2) * planes.stride;
+      if (v < box.y || v >= box.y + box.height) {
+        memset(y, y_value, width);
+        memset(uv, 128, width);
+        continue;
+      }
+      memset(y, y_value, left);
+      memset(y + right_begin, y_value, right);
+      memset(uv, 128, left);
+      memset(uv + right_begin, 128, right);
+    }
+  }
+
+  // planar output row `v` of the box, bilinear from the source
+  static void InterpolateRow(float *const *dst,
+                             RowCache &cache,
+                             Source const &source,
+                             Axis const &x_axis,
+                             Axis const &y_axis,
+                             size_t v) {
+    int32_t index[2] = {y_axis.index0[v], y_axis.index1[v]};
+    size_t slot[2] = {0U, 1U};
+    bool cached[2] = {false, false};
+    for (size_t i = 0U; i < 2U; i++) {
+      for (size_t s = 0U; s < 2U; s++) {
+        if (cache.index[s] == index[i]) {
+          slot[i] = s;
+          cached[i] = true;
+        }
+      }
+    }
+    for (size_t i = 0U; i < 2U; i++) {
+      if (cached[i]) {
+        continue;
+      }
+      // take the slot the other row does not use
+      slot[i] = cached[1U - i] ? 1U - slot[1U - i] : i;
+      cache.index[slot[i]] = index[i];
+      float *rows[3];
+      for (size_t c = 0U; c < source.channels; c++) {
+        rows[c] = cache.Get(slot[i], c);
+      }
+      size_t offset = static_cast<size_t>(index[i]) * source.stride;
+      HorizontalRow(rows, source.data + offset, source, x_axis);
+    }
+    for (size_t c = 0U; c < source.channels; c++) {
+      Lerp(dst[c],
+           cache.Get(slot[0], c),
+           cache.Get(slot[1], c),
+           y_axis.weight[v],
+           cache.width);
+    }
+  }
+
+  static void HorizontalRow(float *const *dst,
+                            uint8_t const *src,
+                            Source const &source,
+                            Axis const &axis) {
+    size_t count = axis.weight.size();
+    for (size_t c = 0U; c < source.channels; c++) {
+      float *row = dst[c];
+      uint8_t const *channel = src + source.order[c];
+      for (size_t i = 0U; i < count; i++) {
+        float a =
+            channel[static_cast<size_t>(axis.index0[i]) * source.channels];
+        float b =
+            channel[static_cast<size_t>(axis.index1[i]) * source.channels];
+        row[i] = a + (b - a) * axis.weight[i];
+      }
+    }
+  }
+
+  // dst = a + (b - a) * weight
+  static void Lerp(float *dst,
+                   float const *a,
+                   float const *b,
+                   float weight,
+                   size_t count) {
+    size_t i = 0U;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t w = vdupq_n_f32(weight);
+    for (; i + 4U <= count; i += 4U) {
+      float32x4_t va = vld1q_f32(a + i);
+      vst1q_f32(dst + i, vmlaq_f32(va, vsubq_f32(vld1q_f32(b + i), va), w));
+    }
+#elif defined(__SSE2__)
+    __m128 w = _mm_set1_ps(weight);
+    for (; i + 4U <= count; i += 4U) {
+      __m128 va = _mm_loadu_ps(a + i);
+      _mm_storeu_ps(
+          dst + i,
+          _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + i), va), w)));
+    }
+#endif
+    for (; i < count; i++) {
+      dst[i] = a[i] + (b[i] - a[i]) * weight;
+    }
+  }
+
+  // BT.601 limited range, values are rounded by truncating value + 0.5
+  static constexpr float kYr = 0.257F, kYg = 0.504F, kYb = 0.098F;
+  static constexpr float kUr = -0.148F, kUg = -0.291F, kUb = 0.439F;
+  static constexpr float kVr = 0.439F, kVg = -0.368F, kVb = -0.071F;
+
+  static uint8_t ToY(float r, float g, float b) {
+    return static_cast<uint8_t>(kYr * r + kYg * g + kYb * b + 16.5F);
+  }
+
+  static void StoreY(uint8_t *dst,
+                     float const *r,
+                     float const *g,
+                     float const *b,
+                     size_t count) {
+    size_t i = 0U;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8U <= count; i += 8U) {
+      uint16x4_t y[2];
+      for (size_t j = 0U; j < 2U; j++) {
+        size_t k = i + 4U * j;
+        float32x4_t value = vdupq_n_f32(16.5F);
+        value = vmlaq_n_f32(value, vld1q_f32(r + k), kYr);
+        value = vmlaq_n_f32(value, vld1q_f32(g + k), kYg);
+        value = vmlaq_n_f32(value, vld1q_f32(b + k), kYb);
+        y[j] = vmovn_u32(vcvtq_u32_f32(value));
+      }
+      vst1_u8(dst + i, vmovn_u16(vcombine_u16(y[0], y[1])));
+    }
+#elif defined(__SSE2__)
+    for (; i + 8U <= count; i += 8U) {
+      __m128i y[2];
+      for (size_t j = 0U; j < 2U; j++) {
+        size_t k = i + 4U * j;
+        __m128 value = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(r + k), _mm_set1_ps(kYr)),
+                       _mm_mul_ps(_mm_loadu_ps(g + k), _mm_set1_ps(kYg))),
+            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(b + k), _mm_set1_ps(kYb)),
+                       _mm_set1_ps(16.5F)));
+        y[j] = _mm_cvttps_epi32(value);
+      }
+      __m128i value = _mm_packs_epi32(y[0], y[1]);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i),
+                       _mm_packus_epi16(value, value));
+    }
+#endif
+    for (; i < count; i++) {
+      dst[i] = ToY(r[i], g[i], b[i]);
+    }
+  }
+
+  // round planar rows of 1 or 2 channels into packed pixels
+  static void StorePacked(uint8_t *dst,
+                          float *const *rows,
+                          size_t channels,
+                          size_t count) {
+    size_t i = 0U;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t half = vdupq_n_f32(0.5F);
+    auto round8 = [half](float const *src) {
+      uint16x4_t lo = vmovn_u32(vcvtq_u32_f32(vaddq_f32(vld1q_f32(src), half)));
+      uint16x4_t hi =
+          vmovn_u32(vcvtq_u32_f32(vaddq_f32(vld1q_f32(src + 4U), half)));
+      return vmovn_u16(vcombine_u16(lo, hi));
+    };
+    for (; i + 8U <= count; i += 8U) {
+      if (channels == 1U) {
+        vst1_u8(dst + i, round8(rows[0] + i));
+      } else {
+        uint8x8x2_t value = {{round8(rows[0] + i), round8(rows[1] + i)}};
+        vst2_u8(dst + 2U * i, value);
+      }
+    }
+#elif defined(__SSE2__)
+    __m128 half = _mm_set1_ps(0.5F);
+    auto round8 = [half](float const *src) {
+      __m128i value = _mm_packs_epi32(
+          _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(src), half)),
+          _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(src + 4U), half)));
+      return _mm_packus_epi16(value, value);
+    };
+    for (; i + 8U <= count; i += 8U) {
+      if (channels == 1U) {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i),
+                         round8(rows[0] + i));
+      } else {
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(dst + 2U * i),
+            _mm_unpacklo_epi8(round8(rows[0] + i), round8(rows[1] + i)));
+      }
+    }
+#endif
+    for (; i < count; i++) {
+      for (size_t c = 0U; c < channels; c++) {
+        dst[i * channels + c] = static_cast<uint8_t>(rows[c][i] + 0.5F);
+      }
+    }
+  }
+
+  // interleaved UV of the 2x2 means of two planar RGB rows
+  static void StoreUv(uint8_t *dst,
+                      float *const *top,
+                      float *const *bottom,
+                      size_t count) {
+    size_t i = 0U;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8U <= count; i += 8U) {
+      float32x4_t mean[3];
+      for (size_t c = 0U; c < 3U; c++) {
+        float32x4_t lo =
+            vaddq_f32(vld1q_f32(top[c] + i), vld1q_f32(bottom[c] + i));
+        float32x4_t hi = vaddq_f32(vld1q_f32(top[c] + i + 4U),
+                                   vld1q_f32(bottom[c] + i + 4U));
+        float32x4_t sum =
+            vcombine_f32(vpadd_f32(vget_low_f32(lo), vget_high_f32(lo)),
+                         vpadd_f32(vget_low_f32(hi), vget_high_f32(hi)));
+        mean[c] = vmulq_n_f32(sum, 0.25F);
+      }
+      float32x4_t u = vdupq_n_f32(128.5F);
+      u = vmlaq_n_f32(u, mean[0], kUr);
+      u = vmlaq_n_f32(u, mean[1], kUg);
+      u = vmlaq_n_f32(u, mean[2], kUb);
+      float32x4_t v = vdupq_n_f32(128.5F);
+      v = vmlaq_n_f32(v, mean[0], kVr);
+      v = vmlaq_n_f32(v, mean[1], kVg);
+      v = vmlaq_n_f32(v, mean[2], kVb);
+      uint16x4x2_t uv =
+          vzip_u16(vmovn_u32(vcvtq_u32_f32(u)), vmovn_u32(vcvtq_u32_f32(v)));
+      vst1_u8(dst + i, vmovn_u16(vcombine_u16(uv.val[0], uv.val[1])));
+    }
+#elif defined(__SSE2__)
+    __m128 quarter = _mm_set1_ps(0.25F);
+    for (; i + 8U <= count; i += 8U) {
+      __m128 mean[3];
+      for (size_t c = 0U; c < 3U; c++) {
+        __m128 lo =
+            _mm_add_ps(_mm_loadu_ps(top[c] + i), _mm_loadu_ps(bottom[c] + i));
+        __m128 hi = _mm_add_ps(_mm_loadu_ps(top[c] + i + 4U),
+                               _mm_loadu_ps(bottom[c] + i + 4U));
+        __m128 even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        mean[c] = _mm_mul_ps(_mm_add_ps(even, odd), quarter);
+      }
+      __m128 u = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(mean[0], _mm_set1_ps(kUr)),
+                     _mm_mul_ps(mean[1], _mm_set1_ps(kUg))),
+          _mm_add_ps(_mm_mul_ps(mean[2], _mm_set1_ps(kUb)),
+                     _mm_set1_ps(128.5F)));
+      __m128 v = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(mean[0], _mm_set1_ps(kVr)),
+                     _mm_mul_ps(mean[1], _mm_set1_ps(kVg))),
+          _mm_add_ps(_mm_mul_ps(mean[2], _mm_set1_ps(kVb)),
+                     _mm_set1_ps(128.5F)));
+      // u0..u3 v0..v3, then interleaved to u0 v0 u1 v1 ...
+      __m128i value =
+          _mm_packs_epi32(_mm_cvttps_epi32(u), _mm_cvttps_epi32(v));
+      value = _mm_unpacklo_epi16(value, _mm_unpackhi_epi64(value, value));
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i),
+                       _mm_packus_epi16(value, value));
+    }
+#endif
+    for (; i + 2U <= count; i += 2U) {
+      float mean[3];
+      for (size_t c = 0U; c < 3U; c++) {
+        mean[c] = (top[c][i] + top[c][i + 1U] + bottom[c][i] +
+                   bottom[c][i + 1U]) *
+                  0.25F;
+      }
+      dst[i] = static_cast<uint8_t>(kUr * mean[0] + kUg * mean[1] +
+                                    kUb * mean[2] + 128.5F);
+      dst[i + 1U] = static_cast<uint8_t>(kVr * mean[0] + kVg * mean[1] +
+                                         kVb * mean[2] + 128.5F);
+    }
+  }
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_IMAGE_CONVERT_H_
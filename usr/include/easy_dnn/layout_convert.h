@@ -0,0 +1,683 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_LAYOUT_CONVERT_H_
+#define _EASY_DNN_LAYOUT_CONVERT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "dnn/hb_dnn.h"
+#include "dnn/hb_dnn_ext.h"
+#include "easy_dnn/byte_swap.h"
+#include "easy_dnn/status.h"
+#include "easy_dnn/thread_pool.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Layout conversion between `HB_DNN_LAYOUT_NHWC` and `HB_DNN_LAYOUT_NCHW`.
+ * Conversion is done as cache blocked 2D transposes with NEON (or SSE2 on
+ *    x86) micro kernels, large tensors are split across `ThreadPool`.
+ *    Endianness conversion is fused into the same pass: copied rows are
+ *    swapped on the way and transposed blocks while still in cache.
+ *    Other layouts (e.g. `HB_DNN_LAYOUT_NHCW_NATIVE`) and packed 4 bit or
+ *    NV12 data are passed to `hbDNNConvertLayout`/`hbDNNConvertLayoutRoi`.
+ */
+class LayoutConvert {
+ public:
+  /**
+   * Get byte size of one element
+   * @param[in] data_type
+   * @return element size, 0 if elements are not byte addressable
+   */
+  static int32_t ElementSize(int32_t data_type) {
+    switch (data_type) {
+      case HB_DNN_IMG_TYPE_Y:
+      case HB_DNN_IMG_TYPE_YUV444:
+      case HB_DNN_IMG_TYPE_RGB:
+      case HB_DNN_IMG_TYPE_BGR:
+      case HB_DNN_TENSOR_TYPE_S8:
+      case HB_DNN_TENSOR_TYPE_U8:
+        return 1;
+      case HB_DNN_TENSOR_TYPE_F16:
+      case HB_DNN_TENSOR_TYPE_S16:
+      case HB_DNN_TENSOR_TYPE_U16:
+        return 2;
+      case HB_DNN_TENSOR_TYPE_F32:
+      case HB_DNN_TENSOR_TYPE_S32:
+      case HB_DNN_TENSOR_TYPE_U32:
+        return 4;
+      case HB_DNN_TENSOR_TYPE_F64:
+      case HB_DNN_TENSOR_TYPE_S64:
+      case HB_DNN_TENSOR_TYPE_U64:
+        return 8;
+      default:
+        return 0;
+    }
+  }
+
+  /**
+   * Convert data layout, same as `hbDNNConvertLayout`
+   * @param[out] output
+   * @param[in] output_layout
+   * @param[in] input
+   * @param[in] input_layout
+   * @param[in] data_type
+   * @param[in] input_shape
+   * @param[in] convert_endianness, also reverse bytes of each element
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Convert(void *output,
+                         int32_t output_layout,
+                         void const *input,
+                         int32_t input_layout,
+                         int32_t data_type,
+                         hbDNNTensorShape const &input_shape,
+                         bool convert_endianness = false) {
+    if (!IsSupported(output_layout, input_layout, data_type, input_shape)) {
+      return hbDNNConvertLayout(output,
+                                output_layout,
+                                input,
+                                input_layout,
+                                data_type,
+                                input_shape,
+                                convert_endianness);
+    }
+    hbDNNDimension coord{{0, 0, 0, 0}, 4};
+    return ConvertRoi(output,
+                      output_layout,
+                      input,
+                      input_layout,
+                      data_type,
+                      input_shape,
+                      coord,
+                      input_shape,
+                      convert_endianness);
+  }
+
+  /**
+   * Convert data layout of a roi, same as `hbDNNConvertLayoutRoi`, output
+   *    is the dense roi
+   * @param[out] output
+   * @param[in] output_layout
+   * @param[in] input
+   * @param[in] input_layout
+   * @param[in] data_type
+   * @param[in] input_shape
+   * @param[in] coord, start of roi in `input_layout` order, inclusive
+   * @param[in] size, size of roi in `input_layout` order
+   * @param[in] convert_endianness, also reverse bytes of each element
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t ConvertRoi(void *output,
+                            int32_t output_layout,
+                            void const *input,
+                            int32_t input_layout,
+                            int32_t data_type,
+                            hbDNNTensorShape const &input_shape,
+                            hbDNNDimension const &coord,
+                            hbDNNDimension const &size,
+                            bool convert_endianness = false) {
+    if (!IsSupported(output_layout, input_layout, data_type, input_shape)) {
+      return hbDNNConvertLayoutRoi(output,
+                                   output_layout,
+                                   input,
+                                   input_layout,
+                                   data_type,
+                                   input_shape,
+                                   convert_endianness,
+                                   coord,
+                                   size);
+    }
+    if (output == nullptr || input == nullptr) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    for (int32_t i = 0; i < 4; i++) {
+      if (coord.dimensionSize[i] < 0 || size.dimensionSize[i] <= 0 ||
+          coord.dimensionSize[i] + size.dimensionSize[i] >
+              input_shape.dimensionSize[i]) {
+        return DNN_INVALID_ARGUMENT;
+      }
+    }
+    size_t element_size = static_cast<size_t>(ElementSize(data_type));
+    std::vector<Plane> planes;
+    if (output_layout == input_layout) {
+      CopyRoi(planes, output, input, input_shape, coord, size, element_size);
+    } else {
+      TransposeRoi(planes,
+                   output,
+                   input,
+                   input_layout,
+                   input_shape,
+                   coord,
+                   size,
+                   element_size);
+    }
+    Run(planes, element_size, convert_endianness);
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Transpose a matrix, `dst[j][i] = src[i][j]`
+   * @param[out] dst
+   * @param[in] dst_stride, elements between rows of dst
+   * @param[in] src
+   * @param[in] src_stride, elements between rows of src
+   * @param[in] rows, rows of src
+   * @param[in] cols, columns of src
+   * @param[in] element_size, 1, 2, 4 or 8
+   * @param[in] convert_endianness, also reverse bytes of each element
+   */
+  static void Transpose(void *dst,
+                        size_t dst_stride,
+                        void const *src,
+                        size_t src_stride,
+                        size_t rows,
+                        size_t cols,
+                        size_t element_size,
+                        bool convert_endianness = false) {
+    switch (element_size) {
+      case 1U:
+        TransposeImpl(static_cast<uint8_t *>(dst),
+                      dst_stride,
+                      static_cast<uint8_t const *>(src),
+                      src_stride,
+                      rows,
+                      cols,
+                      convert_endianness);
+        break;
+      case 2U:
+        TransposeImpl(static_cast<uint16_t *>(dst),
+                      dst_stride,
+                      static_cast<uint16_t const *>(src),
+                      src_stride,
+                      rows,
+                      cols,
+                      convert_endianness);
+        break;
+      case 4U:
+        TransposeImpl(static_cast<uint32_t *>(dst),
+                      dst_stride,
+                      static_cast<uint32_t const *>(src),
+                      src_stride,
+                      rows,
+                      cols,
+                      convert_endianness);
+        break;
+      case 8U:
+        TransposeImpl(static_cast<uint64_t *>(dst),
+                      dst_stride,
+                      static_cast<uint64_t const *>(src),
+                      src_stride,
+                      rows,
+                      cols,
+                      convert_endianness);
+        break;
+      default:
+        break;
+    }
+  }
+
+ private:
+  // tensors smaller than this are converted on the calling thread
+  static constexpr size_t kParallelBytes = 256U << 10;
+  // edge of a cache block, in elements
+  static constexpr size_t kBlock = 64U;
+
+  // one 2D copy or transpose, strides of a copy are in bytes, strides of a
+  //    transpose are in elements
+  struct Plane {
+    uint8_t *dst;
+    uint8_t const *src;
+    size_t dst_stride;
+    size_t src_stride;
+    size_t rows;
+    size_t cols;
+    bool transpose;
+  };
+
+  static bool IsSupported(int32_t output_layout,
+                          int32_t input_layout,
+                          int32_t data_type,
+                          hbDNNTensorShape const &input_shape) {
+    auto is_plain = [](int32_t layout) {
+      return layout == HB_DNN_LAYOUT_NHWC || layout == HB_DNN_LAYOUT_NCHW;
+    };
+    return is_plain(output_layout) && is_plain(input_layout) &&
+           ElementSize(data_type) > 0 && input_shape.numDimensions == 4;
+  }
+
+  static void CopyRoi(std::vector<Plane> &planes,
+                      void *output,
+                      void const *input,
+                      hbDNNTensorShape const &shape,
+                      hbDNNDimension const &coord,
+                      hbDNNDimension const &size,
+                      size_t element_size) {
+    int32_t const *dim = shape.dimensionSize;
+    int32_t const *begin = coord.dimensionSize;
+    int32_t const *count = size.dimensionSize;
+    // innermost dimension is one row, rows of dim 2 are one plane
+    size_t row_bytes = static_cast<size_t>(count[3]) * element_size;
+    auto *dst = static_cast<uint8_t *>(output);
+    auto const *src = static_cast<uint8_t const *>(input);
+    for (int32_t i = 0; i < count[0]; i++) {
+      for (int32_t j = 0; j < count[1]; j++) {
+        size_t offset =
+            ((static_cast<size_t>(begin[0] + i) * dim[1] + begin[1] + j) *
+                 dim[2] +
+             begin[2]) *
+                dim[3] +
+            begin[3];
+        planes.push_back(Plane{dst,
+                               src + offset * element_size,
+                               row_bytes,
+                               static_cast<size_t>(dim[3]) * element_size,
+                               static_cast<size_t>(count[2]),
+                               row_bytes,
+                               false});
+        dst += row_bytes * count[2];
+      }
+    }
+  }
+
+  static void TransposeRoi(std::vector<Plane> &planes,
+                           void *output,
+                           void const *input,
+                           int32_t input_layout,
+                           hbDNNTensorShape const &shape,
+                           hbDNNDimension const &coord,
+                           hbDNNDimension const &size,
+                           size_t element_size) {
+    int32_t const *dim = shape.dimensionSize;
+    int32_t const *begin = coord.dimensionSize;
+    int32_t const *count = size.dimensionSize;
+    bool nhwc = input_layout == HB_DNN_LAYOUT_NHWC;
+    size_t h = static_cast<size_t>(nhwc ? dim[1] : dim[2]);
+    size_t w = static_cast<size_t>(nhwc ? dim[2] : dim[3]);
+    size_t c = static_cast<size_t>(nhwc ? dim[3] : dim[1]);
+    size_t h0 = static_cast<size_t>(nhwc ? begin[1] : begin[2]);
+    size_t w0 = static_cast<size_t>(nhwc ? begin[2] : begin[3]);
+    size_t c0 = static_cast<size_t>(nhwc ? begin[3] : begin[1]);
+    size_t hr = static_cast<size_t>(nhwc ? count[1] : count[2]);
+    size_t wr = static_cast<size_t>(nhwc ? count[2] : count[3]);
+    size_t cr = static_cast<size_t>(nhwc ? count[3] : count[1]);
+    // rows of a full width roi are contiguous, merge them into one plane
+    size_t plane_count = wr == w ? 1U : hr;
+    size_t plane_hw = wr == w ? hr * wr : wr;
+    for (int32_t i = 0; i < count[0]; i++) {
+      size_t ni = static_cast<size_t>(begin[0] + i);
+      for (size_t j = 0U; j < plane_count; j++) {
+        Plane plane;
+        plane.transpose = true;
+        if (nhwc) {
+          // (hw, c) to (c, hw)
+          plane.src = static_cast<uint8_t const *>(input) +
+                      (((ni * h + h0 + j) * w + w0) * c + c0) * element_size;
+          plane.src_stride = c;
+          plane.rows = plane_hw;
+          plane.cols = cr;
+          plane.dst = static_cast<uint8_t *>(output) +
+                      (static_cast<size_t>(i) * cr * hr * wr + j * wr) *
+                          element_size;
+          plane.dst_stride = hr * wr;
+        } else {
+          // (c, hw) to (hw, c)
+          plane.src = static_cast<uint8_t const *>(input) +
+                      (((ni * c + c0) * h + h0 + j) * w + w0) * element_size;
+          plane.src_stride = h * w;
+          plane.rows = cr;
+          plane.cols = plane_hw;
+          plane.dst = static_cast<uint8_t *>(output) +
+                      (static_cast<size_t>(i) * hr * wr * cr + j * wr * cr) *
+                          element_size;
+          plane.dst_stride = cr;
+        }
+        planes.push_back(plane);
+      }
+    }
+  }
+
+  static void Run(std::vector<Plane> &planes,
+                  size_t element_size,
+                  bool convert_endianness) {
+    size_t total_bytes = 0U;
+    for (auto const &plane : planes) {
+      total_bytes += plane.rows * plane.cols *
+                     (plane.transpose ? element_size : 1U);
+    }
+    ThreadPool &pool = ThreadPool::GetInstance();
+    size_t thread_count = static_cast<size_t>(pool.GetThreadCount());
+    if (total_bytes < kParallelBytes || thread_count <= 1U) {
+      for (auto const &plane : planes) {
+        RunPlane(plane, 0U, plane.rows, element_size, convert_endianness);
+      }
+      return;
+    }
+
+    // split planes into bands of rows, so few large planes still spread
+    struct Band {
+      size_t plane;
+      size_t begin;
+      size_t end;
+    };
+    std::vector<Band> bands;
+    for (size_t i = 0U; i < planes.size(); i++) {
+      size_t rows = planes[i].rows;
+      size_t band_rows = rows;
+      if (planes.size() < thread_count) {
+        size_t split = thread_count / planes.size() + 1U;
+        band_rows = ((rows + split - 1U) / split + 7U) & ~size_t{7U};
+      }
+      for (size_t begin = 0U; begin < rows; begin += band_rows) {
+        bands.push_back(Band{i, begin, std::min(rows, begin + band_rows)});
+      }
+    }
+    pool.ParallelFor(bands.size(), 1U, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; i++) {
+        RunPlane(planes[bands[i].plane],
+                 bands[i].begin,
+                 bands[i].end,
+                 element_size,
+                 convert_endianness);
+      }
+    });
+  }
+
+  static void RunPlane(Plane const &plane,
+                       size_t begin,
+                       size_t end,
+                       size_t element_size,
+                       bool convert_endianness) {
+    if (!plane.transpose) {
+      for (size_t i = begin; i < end; i++) {
+        uint8_t *dst = plane.dst + i * plane.cols;
+        uint8_t const *src = plane.src + i * plane.src_stride;
+        if (convert_endianness) {
+          ByteSwap::Swap(dst, src, plane.cols / element_size, element_size);
+        } else {
+          memcpy(dst, src, plane.cols);
+        }
+      }
+      return;
+    }
+    Transpose(plane.dst + begin * element_size,
+              plane.dst_stride,
+              plane.src + begin * plane.src_stride * element_size,
+              plane.src_stride,
+              end - begin,
+              plane.cols,
+              element_size,
+              convert_endianness);
+  }
+
+  template <typename T>
+  static void TransposeImpl(T *dst,
+                            size_t dst_stride,
+                            T const *src,
+                            size_t src_stride,
+                            size_t rows,
+                            size_t cols,
+                            bool convert_endianness) {
+    size_t const micro = MicroSize(static_cast<T *>(nullptr));
+    for (size_t i0 = 0U; i0 < rows; i0 += kBlock) {
+      size_t i1 = std::min(rows, i0 + kBlock);
+      for (size_t j0 = 0U; j0 < cols; j0 += kBlock) {
+        size_t j1 = std::min(cols, j0 + kBlock);
+        size_t i = i0;
+        for (; i + micro <= i1; i += micro) {
+          size_t j = j0;
+          for (; j + micro <= j1; j += micro) {
+            TransposeMicro(dst + j * dst_stride + i,
+                           dst_stride,
+                           src + i * src_stride + j,
+                           src_stride);
+          }
+          TransposeScalar(
+              dst, dst_stride, src, src_stride, i, i + micro, j, j1);
+        }
+        TransposeScalar(dst, dst_stride, src, src_stride, i, i1, j0, j1);
+        if (convert_endianness) {
+          // the block was just written, swap it while it is in cache
+          for (size_t j = j0; j < j1; j++) {
+            T *row = dst + j * dst_stride + i0;
+            ByteSwap::Swap(row, row, i1 - i0, sizeof(T));
+          }
+        }
+      }
+    }
+  }
+
+  template <typename T>
+  static void TransposeScalar(T *dst,
+                              size_t dst_stride,
+                              T const *src,
+                              size_t src_stride,
+                              size_t i0,
+                              size_t i1,
+                              size_t j0,
+                              size_t j1) {
+    for (size_t i = i0; i < i1; i++) {
+      for (size_t j = j0; j < j1; j++) {
+        dst[j * dst_stride + i] = src[i * src_stride + j];
+      }
+    }
+  }
+
+  static constexpr size_t MicroSize(uint8_t *) { return 8U; }
+  static constexpr size_t MicroSize(uint16_t *) { return 8U; }
+  static constexpr size_t MicroSize(uint32_t *) { return 4U; }
+  static constexpr size_t MicroSize(uint64_t *) { return 2U; }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  static void TransposeMicro(uint8_t *dst,
+                             size_t ds,
+                             uint8_t const *src,
+                             size_t ss) {
+    uint8x8x2_t t01 = vtrn_u8(vld1_u8(src), vld1_u8(src + ss));
+    uint8x8x2_t t23 = vtrn_u8(vld1_u8(src + 2U * ss), vld1_u8(src + 3U * ss));
+    uint8x8x2_t t45 = vtrn_u8(vld1_u8(src + 4U * ss), vld1_u8(src + 5U * ss));
+    uint8x8x2_t t67 = vtrn_u8(vld1_u8(src + 6U * ss), vld1_u8(src + 7U * ss));
+    uint16x4x2_t u02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]),
+                                vreinterpret_u16_u8(t23.val[0]));
+    uint16x4x2_t u13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]),
+                                vreinterpret_u16_u8(t23.val[1]));
+    uint16x4x2_t u46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]),
+                                vreinterpret_u16_u8(t67.val[0]));
+    uint16x4x2_t u57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]),
+                                vreinterpret_u16_u8(t67.val[1]));
+    uint32x2x2_t v0 = vtrn_u32(vreinterpret_u32_u16(u02.val[0]),
+                               vreinterpret_u32_u16(u46.val[0]));
+    uint32x2x2_t v1 = vtrn_u32(vreinterpret_u32_u16(u13.val[0]),
+                               vreinterpret_u32_u16(u57.val[0]));
+    uint32x2x2_t v2 = vtrn_u32(vreinterpret_u32_u16(u02.val[1]),
+                               vreinterpret_u32_u16(u46.val[1]));
+    uint32x2x2_t v3 = vtrn_u32(vreinterpret_u32_u16(u13.val[1]),
+                               vreinterpret_u32_u16(u57.val[1]));
+    vst1_u8(dst, vreinterpret_u8_u32(v0.val[0]));
+    vst1_u8(dst + ds, vreinterpret_u8_u32(v1.val[0]));
+    vst1_u8(dst + 2U * ds, vreinterpret_u8_u32(v2.val[0]));
+    vst1_u8(dst + 3U * ds, vreinterpret_u8_u32(v3.val[0]));
+    vst1_u8(dst + 4U * ds, vreinterpret_u8_u32(v0.val[1]));
+    vst1_u8(dst + 5U * ds, vreinterpret_u8_u32(v1.val[1]));
+    vst1_u8(dst + 6U * ds, vreinterpret_u8_u32(v2.val[1]));
+    vst1_u8(dst + 7U * ds, vreinterpret_u8_u32(v3.val[1]));
+  }
+
+  static void TransposeMicro(uint16_t *dst,
+                             size_t ds,
+                             uint16_t const *src,
+                             size_t ss) {
+    uint16x8x2_t t01 = vtrnq_u16(vld1q_u16(src), vld1q_u16(src + ss));
+    uint16x8x2_t t23 =
+        vtrnq_u16(vld1q_u16(src + 2U * ss), vld1q_u16(src + 3U * ss));
+    uint16x8x2_t t45 =
+        vtrnq_u16(vld1q_u16(src + 4U * ss), vld1q_u16(src + 5U * ss));
+    uint16x8x2_t t67 =
+        vtrnq_u16(vld1q_u16(src + 6U * ss), vld1q_u16(src + 7U * ss));
+    uint32x4x2_t u0 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[0]),
+                                vreinterpretq_u32_u16(t23.val[0]));
+    uint32x4x2_t u1 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[1]),
+                                vreinterpretq_u32_u16(t23.val[1]));
+    uint32x4x2_t u2 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[0]),
+                                vreinterpretq_u32_u16(t67.val[0]));
+    uint32x4x2_t u3 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[1]),
+                                vreinterpretq_u32_u16(t67.val[1]));
+    auto store = [](uint16_t *row, uint32x4_t lo, uint32x4_t hi, bool high) {
+      uint32x2_t a = high ? vget_high_u32(lo) : vget_low_u32(lo);
+      uint32x2_t b = high ? vget_high_u32(hi) : vget_low_u32(hi);
+      vst1q_u16(row, vreinterpretq_u16_u32(vcombine_u32(a, b)));
+    };
+    store(dst, u0.val[0], u2.val[0], false);
+    store(dst + ds, u1.val[0], u3.val[0], false);
+    store(dst + 2U * ds, u0.val[1], u2.val[1], false);
+    store(dst + 3U * ds, u1.val[1], u3.val[1], false);
+    store(dst + 4U * ds, u0.val[0], u2.val[0], true);
+    store(dst + 5U * ds, u1.val[0], u3.val[0], true);
+    store(dst + 6U * ds, u0.val[1], u2.val[1], true);
+    store(dst + 7U * ds, u1.val[1], u3.val[1], true);
+  }
+
+  static void TransposeMicro(uint32_t *dst,
+                             size_t ds,
+                             uint32_t const *src,
+                             size_t ss) {
+    uint32x4x2_t t01 = vtrnq_u32(vld1q_u32(src), vld1q_u32(src + ss));
+    uint32x4x2_t t23 =
+        vtrnq_u32(vld1q_u32(src + 2U * ss), vld1q_u32(src + 3U * ss));
+    vst1q_u32(dst,
+              vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])));
+    vst1q_u32(
+        dst + ds,
+        vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])));
+    vst1q_u32(
+        dst + 2U * ds,
+        vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])));
+    vst1q_u32(
+        dst + 3U * ds,
+        vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])));
+  }
+#elif defined(__SSE2__)
+  static void TransposeMicro(uint8_t *dst,
+                             size_t ds,
+                             uint8_t const *src,
+                             size_t ss) {
+    auto load = [src, ss](size_t i) {
+      return _mm_loadl_epi64(reinterpret_cast<__m128i const *>(src + i * ss));
+    };
+    __m128i a0 = _mm_unpacklo_epi8(load(0U), load(1U));
+    __m128i a1 = _mm_unpacklo_epi8(load(2U), load(3U));
+    __m128i a2 = _mm_unpacklo_epi8(load(4U), load(5U));
+    __m128i a3 = _mm_unpacklo_epi8(load(6U), load(7U));
+    __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+    __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+    __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+    __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+    __m128i c[4] = {_mm_unpacklo_epi32(b0, b2),
+                    _mm_unpackhi_epi32(b0, b2),
+                    _mm_unpacklo_epi32(b1, b3),
+                    _mm_unpackhi_epi32(b1, b3)};
+    for (size_t i = 0U; i < 4U; i++) {
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + 2U * i * ds), c[i]);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + (2U * i + 1U) * ds),
+                       _mm_unpackhi_epi64(c[i], c[i]));
+    }
+  }
+
+  static void TransposeMicro(uint16_t *dst,
+                             size_t ds,
+                             uint16_t const *src,
+                             size_t ss) {
+    auto load = [src, ss](size_t i) {
+      return _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * ss));
+    };
+    __m128i r0 = load(0U), r1 = load(1U), r2 = load(2U), r3 = load(3U);
+    __m128i r4 = load(4U), r5 = load(5U), r6 = load(6U), r7 = load(7U);
+    __m128i a0 = _mm_unpacklo_epi16(r0, r1);
+    __m128i a1 = _mm_unpackhi_epi16(r0, r1);
+    __m128i a2 = _mm_unpacklo_epi16(r2, r3);
+    __m128i a3 = _mm_unpackhi_epi16(r2, r3);
+    __m128i a4 = _mm_unpacklo_epi16(r4, r5);
+    __m128i a5 = _mm_unpackhi_epi16(r4, r5);
+    __m128i a6 = _mm_unpacklo_epi16(r6, r7);
+    __m128i a7 = _mm_unpackhi_epi16(r6, r7);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+    auto store = [dst, ds](size_t i, __m128i row) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * ds), row);
+    };
+    store(0U, _mm_unpacklo_epi64(b0, b4));
+    store(1U, _mm_unpackhi_epi64(b0, b4));
+    store(2U, _mm_unpacklo_epi64(b1, b5));
+    store(3U, _mm_unpackhi_epi64(b1, b5));
+    store(4U, _mm_unpacklo_epi64(b2, b6));
+    store(5U, _mm_unpackhi_epi64(b2, b6));
+    store(6U, _mm_unpacklo_epi64(b3, b7));
+    store(7U, _mm_unpackhi_epi64(b3, b7));
+  }
+
+  static void TransposeMicro(uint32_t *dst,
+                             size_t ds,
+                             uint32_t const *src,
+                             size_t ss) {
+    __m128 r0 = _mm_loadu_ps(reinterpret_cast<float const *>(src));
+    __m128 r1 = _mm_loadu_ps(reinterpret_cast<float const *>(src + ss));
+    __m128 r2 = _mm_loadu_ps(reinterpret_cast<float const *>(src + 2U * ss));
+    __m128 r3 = _mm_loadu_ps(reinterpret_cast<float const *>(src + 3U * ss));
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(reinterpret_cast<float *>(dst), r0);
+    _mm_storeu_ps(reinterpret_cast<float *>(dst + ds), r1);
+    _mm_storeu_ps(reinterpret_cast<float *>(dst + 2U * ds), r2);
+    _mm_storeu_ps(reinterpret_cast<float *>(dst + 3U * ds), r3);
+  }
+#else
+  template <typename T>
+  static void TransposeMicro(T *dst, size_t ds, T const *src, size_t ss) {
+    size_t const micro = MicroSize(static_cast<T *>(nullptr));
+    TransposeScalar(dst, ds, src, ss, 0U, micro, 0U, micro);
+  }
+#endif
+
+  static void TransposeMicro(uint64_t *dst,
+                             size_t ds,
+                             uint64_t const *src,
+                             size_t ss) {
+    uint64_t a = src[0], b = src[1], c = src[ss], d = src[ss + 1U];
+    dst[0] = a;
+    dst[1] = c;
+    dst[ds] = b;
+    dst[ds + 1U] = d;
+  }
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_LAYOUT_CONVERT_H_
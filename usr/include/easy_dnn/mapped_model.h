@@ -0,0 +1,251 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_MAPPED_MODEL_H_
+#define _EASY_DNN_MAPPED_MODEL_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Packed model loaded from memory mapped model files.
+ * Model files are mapped read-only and handed to `hbDNNInitializeFromDDR`,
+ *    so no heap copy of the packed model is made on the caller side. Mapped
+ *    pages are backed by the page cache, the kernel can reclaim them under
+ *    memory pressure instead of keeping them in anonymous memory.
+ * Mappings are kept until `Release` since the runtime may refer to model
+ *    data after initialization.
+ * Model files are read (paged in) concurrently before initialization, the
+ *    time of each loading stage is recorded in `LoadProfile`.
+ */
+class MappedPackedModel {
+ public:
+  struct LoadProfile {
+    int32_t read_time{0};  // time of us, map and page in all model files
+    int32_t init_time{0};  // time of us, parse and upload to BPU memory
+  };
+
+  MappedPackedModel() = default;
+  MappedPackedModel(MappedPackedModel const &) = delete;
+  MappedPackedModel &operator=(MappedPackedModel const &) = delete;
+
+  /**
+   * Map model files and initialize packed dnn handle, same as `Map` then
+   *    `Initialize`
+   * @param[in] model_files
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Load(std::vector<std::string> const &model_files) {
+    int32_t ret = Map(model_files);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    return Initialize();
+  }
+
+  /**
+   * Map model files and page them in, without initializing the packed dnn
+   *    handle
+   * @param[in] model_files
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Map(std::vector<std::string> const &model_files) {
+    if (packed_dnn_handle_ != nullptr || !mappings_.empty() ||
+        model_files.empty()) {
+      return DNN_API_USE_ERROR;
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (auto const &model_file : model_files) {
+      void *addr = nullptr;
+      size_t size = 0U;
+      int32_t ret = MapFile(addr, size, model_file);
+      if (ret != DNN_SUCCESS) {
+        UnmapAll();
+        return ret;
+      }
+      mappings_.emplace_back(addr, size);
+    }
+    PageIn();
+    profile_.read_time = static_cast<int32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Initialize packed dnn handle from the mapped model files
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Initialize() {
+    if (packed_dnn_handle_ != nullptr || mappings_.empty()) {
+      return DNN_API_USE_ERROR;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<void const *> model_data;
+    std::vector<int32_t> model_data_lengths;
+    for (auto const &mapping : mappings_) {
+      model_data.push_back(mapping.first);
+      model_data_lengths.push_back(static_cast<int32_t>(mapping.second));
+    }
+    int32_t ret =
+        hbDNNInitializeFromDDR(&packed_dnn_handle_,
+                               model_data.data(),
+                               model_data_lengths.data(),
+                               static_cast<int32_t>(model_data.size()));
+    if (ret != DNN_SUCCESS) {
+      packed_dnn_handle_ = nullptr;
+      UnmapAll();
+    }
+    profile_.init_time = static_cast<int32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+    return ret;
+  }
+
+  /**
+   * Set count of threads reading model files concurrently, default is the
+   *    count of model files, limited by hardware concurrency
+   * @param[in] parallelism, <= 0 means default
+   */
+  void SetReadParallelism(int32_t parallelism) {
+    read_parallelism_ = parallelism;
+  }
+
+  /**
+   * Get time of each stage of the latest `Load`
+   * @return load profile
+   */
+  LoadProfile const &GetLoadProfile() const { return profile_; }
+
+  /**
+   * Get packed dnn handle
+   * @return packed dnn handle if loaded, nullptr otherwise
+   */
+  hbPackedDNNHandle_t GetPackedDNNHandle() const { return packed_dnn_handle_; }
+
+  /**
+   * Get address and size of each mapped model file
+   * @return mappings, empty if not mapped
+   */
+  std::vector<std::pair<void *, size_t>> const &GetMappings() const {
+    return mappings_;
+  }
+
+  /**
+   * Release packed dnn handle and unmap model files
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Release() {
+    int32_t ret = DNN_SUCCESS;
+    if (packed_dnn_handle_ != nullptr) {
+      ret = hbDNNRelease(packed_dnn_handle_);
+      packed_dnn_handle_ = nullptr;
+    }
+    UnmapAll();
+    return ret;
+  }
+
+  ~MappedPackedModel() { Release(); }
+
+ private:
+  static int32_t MapFile(void *&addr, size_t &size, std::string const &file) {
+    int32_t fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return DNN_CAN_NOT_OPEN_FILE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > INT32_MAX) {
+      close(fd);
+      return DNN_INVALID_MODEL;
+    }
+    size = static_cast<size_t>(st.st_size);
+    addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      addr = nullptr;
+      return DNN_OUT_OF_MEMORY;
+    }
+    // model data is parsed front to back once
+    madvise(addr, size, MADV_SEQUENTIAL);
+    return DNN_SUCCESS;
+  }
+
+  void PageIn() {
+    int32_t parallelism = read_parallelism_;
+    if (parallelism <= 0) {
+      parallelism = static_cast<int32_t>(
+          std::max(1U, std::thread::hardware_concurrency()));
+    }
+    parallelism =
+        std::min(parallelism, static_cast<int32_t>(mappings_.size()));
+    std::atomic<size_t> next{0U};
+    auto worker = [this, &next]() {
+      long page_size = sysconf(_SC_PAGESIZE);
+      size_t step = page_size > 0 ? static_cast<size_t>(page_size) : 4096U;
+      for (size_t i = next++; i < mappings_.size(); i = next++) {
+        void *addr = mappings_[i].first;
+        size_t size = mappings_[i].second;
+        auto const *data = static_cast<volatile char const *>(addr);
+        madvise(addr, size, MADV_WILLNEED);
+        for (size_t offset = 0U; offset < size; offset += step) {
+          (void)data[offset];
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (int32_t i = 1; i < parallelism; i++) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  void UnmapAll() {
+    for (auto &mapping : mappings_) {
+      munmap(mapping.first, mapping.second);
+    }
+    mappings_.clear();
+  }
+
+ private:
+  hbPackedDNNHandle_t packed_dnn_handle_{nullptr};
+  std::vector<std::pair<void *, size_t>> mappings_;
+  int32_t read_parallelism_{0};
+  LoadProfile profile_;
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_MAPPED_MODEL_H_
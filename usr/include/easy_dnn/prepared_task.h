@@ -0,0 +1,284 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_PREPARED_TASK_H_
+#define _EASY_DNN_PREPARED_TASK_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Inference task with model handle, tensors and control param bound once.
+ * Inputs and outputs are checked against the model tensor properties in
+ *    `Create`, `Run` only submits the bound descriptors, so the hot path
+ *    does no allocation nor validation.
+ * Bound tensors refer to the caller's memory, the memory must stay valid
+ *    until the prepared task is destroyed. Not thread safe.
+ */
+class PreparedTask {
+ public:
+  /**
+   * Create a prepared task with `hbDNNInfer` semantics
+   * @param[out] task
+   * @param[in] dnn_handle
+   * @param[in] inputs, the size should be equal to $(`hbDNNGetInputCount`)
+   * @param[in] outputs, the size should be equal to $(`hbDNNGetOutputCount`)
+   * @param[in] ctrl_param
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(std::shared_ptr<PreparedTask> &task,
+                        hbDNNHandle_t dnn_handle,
+                        std::vector<hbDNNTensor> const &inputs,
+                        std::vector<hbDNNTensor> const &outputs,
+                        hbDNNInferCtrlParam const &ctrl_param) {
+    std::vector<hbDNNRoi> rois;
+    return Create(task, dnn_handle, inputs, outputs, rois, ctrl_param, false);
+  }
+
+  /**
+   * Create a prepared task with `hbDNNRoiInfer` semantics
+   * @param[out] task
+   * @param[in] dnn_handle
+   * @param[in] inputs, the size should be equal to
+   *    $(`hbDNNGetInputCount`) * `batch`
+   * @param[in] outputs, the size should be equal to
+   *    $(`hbDNNGetOutputCount`) * `batch`
+   * @param[in] rois, initial rois, can be updated by `SetRois` before `Run`
+   * @param[in] ctrl_param
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(std::shared_ptr<PreparedTask> &task,
+                        hbDNNHandle_t dnn_handle,
+                        std::vector<hbDNNTensor> const &inputs,
+                        std::vector<hbDNNTensor> const &outputs,
+                        std::vector<hbDNNRoi> const &rois,
+                        hbDNNInferCtrlParam const &ctrl_param) {
+    return Create(task, dnn_handle, inputs, outputs, rois, ctrl_param, true);
+  }
+
+  /**
+   * Update rois, the roi count must not change
+   * @param[in] rois
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t SetRois(std::vector<hbDNNRoi> const &rois) {
+    if (!roi_infer_ || rois.size() != rois_.size()) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    rois_ = rois;
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Update custom id of next run
+   * @param[in] custom_id
+   */
+  void SetCustomId(int64_t custom_id) { ctrl_param_.customId = custom_id; }
+
+  /**
+   * Submit the bound task, a previous run which has been waited done but not
+   *    released yet will be released first
+   * @return 0 if success, `DNN_API_USE_ERROR` if the previous run is not
+   *    waited done, return defined error code otherwise
+   */
+  int32_t Run() {
+    if (task_handle_ != nullptr && !done_) {
+      // releasing would cancel the run and leave its outputs half written
+      return DNN_API_USE_ERROR;
+    }
+    int32_t ret = Release();
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    hbDNNTensor *output = outputs_.data();
+    if (roi_infer_) {
+      ret = hbDNNRoiInfer(&task_handle_,
+                          &output,
+                          inputs_.data(),
+                          rois_.data(),
+                          static_cast<int32_t>(rois_.size()),
+                          dnn_handle_,
+                          &ctrl_param_);
+    } else {
+      ret = hbDNNInfer(
+          &task_handle_, &output, inputs_.data(), dnn_handle_, &ctrl_param_);
+    }
+    if (ret != DNN_SUCCESS) {
+      task_handle_ = nullptr;
+    }
+    return ret;
+  }
+
+  /**
+   * Wait current run done
+   * @param[in] timeout, timeout of milliseconds
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Wait(int32_t timeout) {
+    if (task_handle_ == nullptr) {
+      return DNN_INVALID_TASK_HANDLE;
+    }
+    int32_t ret = hbDNNWaitTaskDone(task_handle_, timeout);
+    done_ = ret == DNN_SUCCESS;
+    return ret;
+  }
+
+  /**
+   * Release task handle of current run, bound tensors are kept
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Release() {
+    if (task_handle_ == nullptr) {
+      return DNN_SUCCESS;
+    }
+    int32_t ret = hbDNNReleaseTask(task_handle_);
+    task_handle_ = nullptr;
+    done_ = false;
+    return ret;
+  }
+
+  /**
+   * Get task handle of current run
+   * @return task handle if running, nullptr otherwise
+   */
+  hbDNNTaskHandle_t GetTaskHandle() const { return task_handle_; }
+
+  /**
+   * Get bound output tensors
+   * @return output tensors
+   */
+  std::vector<hbDNNTensor> &GetOutputs() { return outputs_; }
+
+  ~PreparedTask() { Release(); }
+
+ private:
+  PreparedTask() = default;
+
+  static int32_t Create(std::shared_ptr<PreparedTask> &task,
+                        hbDNNHandle_t dnn_handle,
+                        std::vector<hbDNNTensor> const &inputs,
+                        std::vector<hbDNNTensor> const &outputs,
+                        std::vector<hbDNNRoi> const &rois,
+                        hbDNNInferCtrlParam const &ctrl_param,
+                        bool roi_infer) {
+    int32_t input_count = 0;
+    int32_t output_count = 0;
+    int32_t ret = hbDNNGetInputCount(&input_count, dnn_handle);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    ret = hbDNNGetOutputCount(&output_count, dnn_handle);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    if (input_count <= 0 || output_count <= 0 || inputs.empty() ||
+        inputs.size() % static_cast<size_t>(input_count) != 0) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    size_t batch = inputs.size() / input_count;
+    if ((!roi_infer && batch != 1) ||
+        outputs.size() != batch * static_cast<size_t>(output_count) ||
+        (roi_infer && rois.empty())) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    for (int32_t i = 0; i < input_count; i++) {
+      hbDNNTensorProperties properties;
+      ret = hbDNNGetInputTensorProperties(&properties, dnn_handle, i);
+      if (ret != DNN_SUCCESS) {
+        return ret;
+      }
+      for (size_t idx = 0; idx < batch; idx++) {
+        if (!Matches(inputs[idx * input_count + i], properties, roi_infer)) {
+          return DNN_INVALID_ARGUMENT;
+        }
+      }
+    }
+    for (int32_t i = 0; i < output_count; i++) {
+      hbDNNTensorProperties properties;
+      ret = hbDNNGetOutputTensorProperties(&properties, dnn_handle, i);
+      if (ret != DNN_SUCCESS) {
+        return ret;
+      }
+      for (size_t idx = 0; idx < batch; idx++) {
+        if (!Matches(outputs[idx * output_count + i], properties, false)) {
+          return DNN_INVALID_ARGUMENT;
+        }
+      }
+    }
+
+    task.reset(new PreparedTask());
+    task->dnn_handle_ = dnn_handle;
+    task->inputs_ = inputs;
+    task->outputs_ = outputs;
+    task->rois_ = rois;
+    task->ctrl_param_ = ctrl_param;
+    task->roi_infer_ = roi_infer;
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Check a bound tensor against the model tensor properties
+   * @param[in] tensor
+   * @param[in] properties
+   * @param[in] roi_input, image size of a roi input is up to the caller,
+   *    only its type is checked
+   * @return true if the tensor can be bound
+   */
+  static bool Matches(hbDNNTensor const &tensor,
+                      hbDNNTensorProperties const &properties,
+                      bool roi_input) {
+    if (tensor.sysMem[0].virAddr == nullptr ||
+        tensor.properties.tensorType != properties.tensorType) {
+      return false;
+    }
+    if (roi_input) {
+      return true;
+    }
+    auto const &shape = tensor.properties.validShape;
+    auto const &model_shape = properties.validShape;
+    if (shape.numDimensions != model_shape.numDimensions) {
+      return false;
+    }
+    for (int32_t i = 0; i < shape.numDimensions; i++) {
+      if (shape.dimensionSize[i] != model_shape.dimensionSize[i]) {
+        return false;
+      }
+    }
+    // planes of NV12_SEPARATE are not in one block
+    return properties.tensorType == HB_DNN_IMG_TYPE_NV12_SEPARATE ||
+           static_cast<int64_t>(tensor.sysMem[0].memSize) >=
+               properties.alignedByteSize;
+  }
+
+ private:
+  hbDNNHandle_t dnn_handle_{nullptr};
+  hbDNNTaskHandle_t task_handle_{nullptr};
+  std::vector<hbDNNTensor> inputs_;
+  std::vector<hbDNNTensor> outputs_;
+  std::vector<hbDNNRoi> rois_;
+  hbDNNInferCtrlParam ctrl_param_{};
+  bool roi_infer_{false};
+  bool done_{false};  // current run waited done
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_PREPARED_TASK_H_
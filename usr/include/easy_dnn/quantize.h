@@ -0,0 +1,587 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_QUANTIZE_H_
+#define _EASY_DNN_QUANTIZE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/byte_swap.h"
+#include "easy_dnn/layout_convert.h"
+#include "easy_dnn/status.h"
+#include "easy_dnn/thread_pool.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Quantization of float data into BPU input tensors, the inverse of
+ *    `Dequantizer`.
+ * `FromFloat` writes the aligned buffer once: values are quantized by
+ *    `properties.quantiType` along `properties.quantizeAxis` as
+ *    `clip(nearbyint(x / scale + zero_point))` or
+ *    `clip(nearbyint(x * 2^shift))`, rounding half to even, and stored by
+ *    `properties.stride`. Padding is zero filled, and dense 4D input is
+ *    converted to the tensor layout on the way, replacing a hand written
+ *    quantize loop followed by `hbDNNAddPadding`.
+ * S8, U8, S16 and U16 tensors are quantized, F32 tensors are copied.
+ *    With `convert_endianness` the bytes of each element are reversed
+ *    before storing, replacing an `hbDNNConvertEndianness` pass.
+ */
+class Quantizer {
+ public:
+  /**
+   * Quantize dense float data into a tensor
+   * @param[inout] tensor, memory allocated by `alignedByteSize`, clean cache
+   *    after call if memory is cached
+   * @param[in] input, element count of `properties.validShape`
+   * @param[in] input_layout, `HB_DNN_LAYOUT_NHWC` or `HB_DNN_LAYOUT_NCHW`
+   *    for 4D tensors, `HB_DNN_LAYOUT_NONE` means the tensor layout
+   * @param[in] convert_endianness, reverse bytes of each tensor element
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t FromFloat(hbDNNTensor &tensor,
+                           float const *input,
+                           int32_t input_layout,
+                           bool convert_endianness = false) {
+    hbDNNTensorProperties const &properties = tensor.properties;
+    int32_t const *valid = properties.validShape.dimensionSize;
+    int32_t dim_num = properties.validShape.numDimensions;
+    int32_t element_size = LayoutConvert::ElementSize(properties.tensorType);
+    if (input == nullptr || tensor.sysMem[0].virAddr == nullptr ||
+        dim_num <= 0 || dim_num > HB_DNN_TENSOR_MAX_DIMENSIONS ||
+        properties.alignedShape.numDimensions != dim_num ||
+        !IsSupportedType(properties.tensorType)) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    for (int32_t i = 0; i < dim_num; i++) {
+      if (valid[i] <= 0 ||
+          valid[i] > properties.alignedShape.dimensionSize[i] ||
+          properties.stride[i] < element_size) {
+        return DNN_INVALID_ARGUMENT;
+      }
+    }
+    bool transpose = input_layout != HB_DNN_LAYOUT_NONE &&
+                     input_layout != properties.tensorLayout;
+    if (transpose &&
+        (dim_num != 4 ||
+         (input_layout != HB_DNN_LAYOUT_NHWC &&
+          input_layout != HB_DNN_LAYOUT_NCHW) ||
+         (properties.tensorLayout != HB_DNN_LAYOUT_NHWC &&
+          properties.tensorLayout != HB_DNN_LAYOUT_NCHW))) {
+      return DNN_INVALID_ARGUMENT;
+    }
+
+    Rows rows;
+    int32_t ret = InitRows(rows, tensor);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    rows.swap = convert_endianness;
+    // rows are walked over the aligned shape, so padding is zeroed by the
+    //    same thread which writes the row
+    if (!transpose) {
+      Parallel(rows.row_count, rows.row_length, [&](size_t b, size_t e) {
+        int32_t index[HB_DNN_TENSOR_MAX_DIMENSIONS];
+        for (size_t r = b; r < e; r++) {
+          size_t src_row = 0U;
+          if (RowIndex(index, rows, r, src_row)) {
+            RunRow(rows, index, input + src_row * rows.row_length);
+          }
+          PadRow(rows, index);
+        }
+      });
+      return DNN_SUCCESS;
+    }
+
+    // one unit is a (n, h) slice, the slice is transposed into a small
+    //    dense block in tensor layout, then quantized row by row
+    bool nhwc = properties.tensorLayout == HB_DNN_LAYOUT_NHWC;
+    int32_t const *aligned = properties.alignedShape.dimensionSize;
+    size_t n = static_cast<size_t>(valid[0]);
+    size_t h = static_cast<size_t>(nhwc ? valid[1] : valid[2]);
+    size_t w = static_cast<size_t>(nhwc ? valid[2] : valid[3]);
+    size_t c = static_cast<size_t>(nhwc ? valid[3] : valid[1]);
+    size_t slice = w * c;
+    size_t aligned_n = static_cast<size_t>(aligned[0]);
+    size_t aligned_h = static_cast<size_t>(nhwc ? aligned[1] : aligned[2]);
+    size_t aligned_rows = static_cast<size_t>(nhwc ? aligned[2] : aligned[1]);
+    Parallel(aligned_n * aligned_h, slice, [&](size_t b, size_t e) {
+      std::vector<float> block(slice);
+      int32_t index[HB_DNN_TENSOR_MAX_DIMENSIONS] = {0};
+      for (size_t u = b; u < e; u++) {
+        size_t ni = u / aligned_h;
+        size_t hi = u % aligned_h;
+        index[0] = static_cast<int32_t>(ni);
+        index[nhwc ? 1 : 2] = static_cast<int32_t>(hi);
+        if (ni >= n || hi >= h) {
+          for (size_t i = 0U; i < aligned_rows; i++) {
+            index[nhwc ? 2 : 1] = static_cast<int32_t>(i);
+            PadRow(rows, index);
+          }
+          continue;
+        }
+        if (nhwc) {
+          // NCHW input (c, w) of this slice to (w, c)
+          LayoutConvert::Transpose(block.data(),
+                                   c,
+                                   input + (ni * c * h + hi) * w,
+                                   h * w,
+                                   c,
+                                   w,
+                                   sizeof(float));
+        } else {
+          // NHWC input (w, c) of this slice to (c, w)
+          LayoutConvert::Transpose(block.data(),
+                                   w,
+                                   input + (ni * h + hi) * w * c,
+                                   c,
+                                   w,
+                                   c,
+                                   sizeof(float));
+        }
+        size_t block_rows = nhwc ? w : c;
+        for (size_t i = 0U; i < aligned_rows; i++) {
+          index[nhwc ? 2 : 1] = static_cast<int32_t>(i);
+          if (i < block_rows) {
+            RunRow(rows, index, block.data() + i * rows.row_length);
+          }
+          PadRow(rows, index);
+        }
+      }
+    });
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Quantize dense data by scale, the inverse of `hbDNNUnquantizeByScale`
+   *    with zero points and any quantize axis
+   * @param[out] output
+   * @param[in] input
+   * @param[in] data_type
+   * @param[in] shape
+   * @param[in] scale
+   * @param[in] quantize_axis, used if scale or zero point is per axis
+   * @param[in] convert_endianness, reverse bytes of each output element
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t QuantizeByScale(void *output,
+                                 float const *input,
+                                 int32_t data_type,
+                                 hbDNNTensorShape const &shape,
+                                 hbDNNQuantiScale const &scale,
+                                 int32_t quantize_axis,
+                                 bool convert_endianness = false) {
+    hbDNNTensor tensor;
+    memset(&tensor, 0, sizeof(tensor));
+    tensor.sysMem[0].virAddr = output;
+    hbDNNTensorProperties &properties = tensor.properties;
+    properties.validShape = shape;
+    properties.alignedShape = shape;
+    properties.tensorLayout = HB_DNN_LAYOUT_NONE;
+    properties.tensorType = data_type;
+    properties.quantiType = SCALE;
+    properties.scale = scale;
+    properties.quantizeAxis = quantize_axis;
+    int32_t stride = LayoutConvert::ElementSize(data_type);
+    for (int32_t i = shape.numDimensions - 1; i >= 0 && stride > 0; i--) {
+      properties.stride[i] = stride;
+      stride *= shape.dimensionSize[i];
+    }
+    return FromFloat(tensor, input, HB_DNN_LAYOUT_NONE, convert_endianness);
+  }
+
+ private:
+  // tensors with less elements are quantized on the calling thread
+  static constexpr size_t kParallelElements = 64U << 10;
+
+  struct Rows {
+    uint8_t *data;
+    int32_t type;
+    int32_t dim_num;
+    int32_t const *valid;
+    int32_t const *aligned;
+    int32_t const *stride;
+    size_t row_count;  // of the aligned shape
+    size_t row_length;
+    bool padded;  // there are bytes beyond the valid shape
+    int32_t axis;
+    bool swap;
+    // value is x / scales[i] + zero_points[i]
+    std::vector<float> scales;
+    std::vector<float> zero_points;
+  };
+
+  // per element arrays if not null, otherwise one value for the row
+  struct Factor {
+    float const *scales;
+    float const *zero_points;
+    float scale;
+    float zero_point;
+  };
+
+  static bool IsSupportedType(int32_t type) {
+    return type == HB_DNN_TENSOR_TYPE_S8 || type == HB_DNN_TENSOR_TYPE_U8 ||
+           type == HB_DNN_TENSOR_TYPE_S16 || type == HB_DNN_TENSOR_TYPE_U16 ||
+           type == HB_DNN_TENSOR_TYPE_F32;
+  }
+
+  static int32_t InitRows(Rows &rows, hbDNNTensor &tensor) {
+    hbDNNTensorProperties const &properties = tensor.properties;
+    rows.data = static_cast<uint8_t *>(tensor.sysMem[0].virAddr);
+    rows.type = properties.tensorType;
+    rows.dim_num = properties.validShape.numDimensions;
+    rows.valid = properties.validShape.dimensionSize;
+    rows.aligned = properties.alignedShape.dimensionSize;
+    rows.stride = properties.stride;
+    rows.row_length = static_cast<size_t>(rows.valid[rows.dim_num - 1]);
+    rows.row_count = 1U;
+    rows.padded = false;
+    for (int32_t i = 0; i < rows.dim_num; i++) {
+      if (i + 1 < rows.dim_num) {
+        rows.row_count *= static_cast<size_t>(rows.aligned[i]);
+      }
+      rows.padded = rows.padded || rows.valid[i] != rows.aligned[i] ||
+                    (i > 0 && rows.stride[i - 1] !=
+                                  rows.aligned[i] * rows.stride[i]);
+    }
+    rows.axis = properties.quantizeAxis;
+    if (properties.quantiType == NONE ||
+        properties.tensorType == HB_DNN_TENSOR_TYPE_F32) {
+      rows.scales.assign(1U, 1.0F);
+      rows.zero_points.assign(1U, 0.0F);
+      return DNN_SUCCESS;
+    }
+    bool scale_type = properties.quantiType == SCALE;
+    int32_t scale_len =
+        scale_type ? properties.scale.scaleLen : properties.shift.shiftLen;
+    int32_t zero_len = scale_type ? properties.scale.zeroPointLen : 0;
+    int32_t len = std::max(scale_len, zero_len);
+    if (scale_len <= 0 || (scale_len != 1 && scale_len != len) ||
+        (zero_len > 1 && zero_len != len) ||
+        (len > 1 && (rows.axis < 0 || rows.axis >= rows.dim_num ||
+                     len < rows.valid[rows.axis]))) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    rows.scales.resize(static_cast<size_t>(len));
+    rows.zero_points.resize(static_cast<size_t>(len));
+    for (int32_t i = 0; i < len; i++) {
+      int32_t si = scale_len == 1 ? 0 : i;
+      rows.scales[i] = scale_type
+                           ? properties.scale.scaleData[si]
+                           : std::ldexp(1.0F, -properties.shift.shiftData[si]);
+      rows.zero_points[i] =
+          zero_len > 0
+              ? static_cast<float>(
+                    properties.scale.zeroPointData[zero_len == 1 ? 0 : i])
+              : 0.0F;
+    }
+    return DNN_SUCCESS;
+  }
+
+  template <typename Fn>
+  static void Parallel(size_t count, size_t unit_elements, Fn const &fn) {
+    if (count * unit_elements < kParallelElements) {
+      fn(0U, count);
+      return;
+    }
+    ThreadPool::GetInstance().ParallelFor(
+        count, kParallelElements / 4U / unit_elements + 1U, fn);
+  }
+
+  // index of an aligned row, return true and its valid row number if it is
+  //    inside the valid shape
+  static bool RowIndex(int32_t *index,
+                       Rows const &rows,
+                       size_t row,
+                       size_t &valid_row) {
+    bool inside = true;
+    size_t count = 1U;
+    valid_row = 0U;
+    for (int32_t i = rows.dim_num - 2; i >= 0; i--) {
+      index[i] = static_cast<int32_t>(row % rows.aligned[i]);
+      row /= rows.aligned[i];
+      inside = inside && index[i] < rows.valid[i];
+      valid_row += static_cast<size_t>(index[i]) * count;
+      count *= static_cast<size_t>(rows.valid[i]);
+    }
+    return inside;
+  }
+
+  // zero the bytes an aligned row owns beyond the valid shape, up to the
+  //    next row, or up to the next block for the last row of a dimension,
+  //    valid data is not touched
+  static void PadRow(Rows const &rows, int32_t const *index) {
+    if (!rows.padded) {
+      return;
+    }
+    int32_t last = rows.dim_num - 1;
+    size_t offset = 0U;
+    bool inside = true;
+    for (int32_t i = 0; i < last; i++) {
+      offset += static_cast<size_t>(index[i]) * rows.stride[i];
+      inside = inside && index[i] < rows.valid[i];
+    }
+    size_t end = offset + (last > 0 ? static_cast<size_t>(rows.stride[last - 1])
+                                    : static_cast<size_t>(rows.aligned[0]) *
+                                          rows.stride[0]);
+    size_t block = offset;
+    for (int32_t i = last - 1; i > 0 && index[i] == rows.aligned[i] - 1; i--) {
+      block -= static_cast<size_t>(index[i]) * rows.stride[i];
+      end = block + rows.stride[i - 1];
+    }
+    size_t begin = offset;
+    if (inside) {
+      begin += static_cast<size_t>(rows.valid[last]) * rows.stride[last];
+    }
+    if (end > begin) {
+      memset(rows.data + begin, 0, end - begin);
+    }
+  }
+
+  static void RunRow(Rows const &rows, int32_t const *index, float const *src) {
+    size_t offset = 0U;
+    for (int32_t i = 0; i + 1 < rows.dim_num; i++) {
+      offset += static_cast<size_t>(index[i]) * rows.stride[i];
+    }
+    uint8_t *dst = rows.data + offset;
+    size_t step = static_cast<size_t>(rows.stride[rows.dim_num - 1]);
+    Factor factor{nullptr, nullptr, rows.scales[0], rows.zero_points[0]};
+    if (rows.scales.size() > 1U) {
+      if (rows.axis == rows.dim_num - 1) {
+        factor.scales = rows.scales.data();
+        factor.zero_points = rows.zero_points.data();
+      } else {
+        factor.scale = rows.scales[index[rows.axis]];
+        factor.zero_point = rows.zero_points[index[rows.axis]];
+      }
+    }
+    switch (rows.type) {
+      case HB_DNN_TENSOR_TYPE_S8:
+        Row<int8_t>(dst, step, src, rows.row_length, rows.swap, factor);
+        break;
+      case HB_DNN_TENSOR_TYPE_U8:
+        Row<uint8_t>(dst, step, src, rows.row_length, rows.swap, factor);
+        break;
+      case HB_DNN_TENSOR_TYPE_S16:
+        Row<int16_t>(dst, step, src, rows.row_length, rows.swap, factor);
+        break;
+      case HB_DNN_TENSOR_TYPE_U16:
+        Row<uint16_t>(dst, step, src, rows.row_length, rows.swap, factor);
+        break;
+      default:
+        Row<float>(dst, step, src, rows.row_length, rows.swap, factor);
+        break;
+    }
+  }
+
+  // NaN maps to 0 like the vector paths, integer casts of NaN are undefined
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value, T>::type
+  Saturate(float value) {
+    if (std::isnan(value)) {
+      return 0;
+    }
+    float lo = static_cast<float>(std::numeric_limits<T>::lowest());
+    float hi = static_cast<float>(std::numeric_limits<T>::max());
+    return static_cast<T>(
+        std::min(std::max(std::nearbyint(value), lo), hi));
+  }
+
+  // float elements are written through, neither rounded nor clamped
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value, T>::type
+  Saturate(float value) {
+    return value;
+  }
+
+  template <typename T>
+  static void Row(uint8_t *bytes,
+                  size_t step,
+                  float const *src,
+                  size_t count,
+                  bool swap,
+                  Factor const &factor) {
+    float const *scales = factor.scales;
+    float const *zero_points = factor.zero_points;
+    size_t i = 0U;
+    if (step == sizeof(T)) {
+      i = Row8(reinterpret_cast<T *>(bytes), src, count, swap, factor);
+    }
+    for (; i < count; i++) {
+      float scale = scales ? scales[i] : factor.scale;
+      float zero_point = zero_points ? zero_points[i] : factor.zero_point;
+      T value = Saturate<T>(src[i] / scale + zero_point);
+      if (swap) {
+        value = ByteSwap::Swap(value);
+      }
+      memcpy(bytes + i * step, &value, sizeof(T));
+    }
+  }
+
+  static size_t Row8(float *dst,
+                     float const *src,
+                     size_t count,
+                     bool swap,
+                     Factor const &) {
+    if (swap) {
+      ByteSwap::Swap(dst, src, count, sizeof(float));
+    } else {
+      memcpy(dst, src, count * sizeof(float));
+    }
+    return count;
+  }
+
+  // quantize groups of 8 elements, return count of elements done
+  template <typename T>
+  static size_t Row8(T *dst,
+                     float const *src,
+                     size_t count,
+                     bool swap,
+                     Factor const &factor) {
+    size_t i = 0U;
+#if defined(__aarch64__)
+    float32x4_t lo_limit =
+        vdupq_n_f32(static_cast<float>(std::numeric_limits<T>::lowest()));
+    float32x4_t hi_limit =
+        vdupq_n_f32(static_cast<float>(std::numeric_limits<T>::max()));
+    float32x4_t scale = vdupq_n_f32(factor.scale);
+    float32x4_t zero_point = vdupq_n_f32(factor.zero_point);
+    for (; i + 8U <= count; i += 8U) {
+      float32x4_t value[2] = {vld1q_f32(src + i), vld1q_f32(src + i + 4U)};
+      for (size_t j = 0U; j < 2U; j++) {
+        size_t k = i + 4U * j;
+        float32x4_t s = factor.scales ? vld1q_f32(factor.scales + k) : scale;
+        float32x4_t z =
+            factor.zero_points ? vld1q_f32(factor.zero_points + k) : zero_point;
+        value[j] = vaddq_f32(vdivq_f32(value[j], s), z);
+        value[j] = vminq_f32(vmaxq_f32(value[j], lo_limit), hi_limit);
+      }
+      Store8(dst + i,
+             vcvtnq_s32_f32(value[0]),
+             vcvtnq_s32_f32(value[1]),
+             swap);
+    }
+#elif defined(__SSE2__) && !defined(__aarch64__)
+    __m128 lo_limit =
+        _mm_set1_ps(static_cast<float>(std::numeric_limits<T>::lowest()));
+    __m128 hi_limit =
+        _mm_set1_ps(static_cast<float>(std::numeric_limits<T>::max()));
+    __m128 scale = _mm_set1_ps(factor.scale);
+    __m128 zero_point = _mm_set1_ps(factor.zero_point);
+    for (; i + 8U <= count; i += 8U) {
+      __m128 value[2] = {_mm_loadu_ps(src + i), _mm_loadu_ps(src + i + 4U)};
+      for (size_t j = 0U; j < 2U; j++) {
+        size_t k = i + 4U * j;
+        __m128 s = factor.scales ? _mm_loadu_ps(factor.scales + k) : scale;
+        __m128 z =
+            factor.zero_points ? _mm_loadu_ps(factor.zero_points + k)
+                               : zero_point;
+        value[j] = _mm_add_ps(_mm_div_ps(value[j], s), z);
+        // NaN to 0 as NEON `vcvtnq` does, `_mm_max_ps` would pick the limit
+        value[j] = _mm_and_ps(value[j], _mm_cmpord_ps(value[j], value[j]));
+        value[j] = _mm_min_ps(_mm_max_ps(value[j], lo_limit), hi_limit);
+      }
+      // default MXCSR rounding is to nearest even
+      Store8(dst + i,
+             _mm_cvtps_epi32(value[0]),
+             _mm_cvtps_epi32(value[1]),
+             swap);
+    }
+#else
+    (void)dst;
+    (void)src;
+    (void)count;
+    (void)swap;
+    (void)factor;
+#endif
+    return i;
+  }
+
+#if defined(__aarch64__)
+  static void Store8(int8_t *dst, int32x4_t lo, int32x4_t hi, bool) {
+    vst1_s8(dst, vqmovn_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi))));
+  }
+
+  static void Store8(uint8_t *dst, int32x4_t lo, int32x4_t hi, bool) {
+    vst1_u8(dst,
+            vqmovn_u16(vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi))));
+  }
+
+  static void Store8(int16_t *dst, int32x4_t lo, int32x4_t hi, bool swap) {
+    Store16(dst,
+            vreinterpretq_u8_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi))),
+            swap);
+  }
+
+  static void Store8(uint16_t *dst, int32x4_t lo, int32x4_t hi, bool swap) {
+    Store16(
+        dst,
+        vreinterpretq_u8_u16(vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi))),
+        swap);
+  }
+
+  static void Store16(void *dst, uint8x16_t value, bool swap) {
+    vst1q_u8(static_cast<uint8_t *>(dst),
+             swap ? ByteSwap::Vector16(value) : value);
+  }
+#elif defined(__SSE2__)
+  static void Store8(int8_t *dst, __m128i lo, __m128i hi, bool) {
+    __m128i value = _mm_packs_epi32(lo, hi);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst),
+                     _mm_packs_epi16(value, value));
+  }
+
+  static void Store8(uint8_t *dst, __m128i lo, __m128i hi, bool) {
+    __m128i value = _mm_packs_epi32(lo, hi);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst),
+                     _mm_packus_epi16(value, value));
+  }
+
+  static void Store8(int16_t *dst, __m128i lo, __m128i hi, bool swap) {
+    Store16(dst, _mm_packs_epi32(lo, hi), swap);
+  }
+
+  static void Store8(uint16_t *dst, __m128i lo, __m128i hi, bool swap) {
+    // no unsigned 32 to 16 pack in SSE2, bias into the signed range
+    __m128i bias = _mm_set1_epi32(32768);
+    __m128i value =
+        _mm_packs_epi32(_mm_sub_epi32(lo, bias), _mm_sub_epi32(hi, bias));
+    Store16(dst, _mm_xor_si128(value, _mm_set1_epi16(-32768)), swap);
+  }
+
+  static void Store16(void *dst, __m128i value, bool swap) {
+    ByteSwap::Store(static_cast<uint8_t *>(dst),
+                    swap ? ByteSwap::Vector16(value) : value);
+  }
+#endif
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_QUANTIZE_H_
@@ -0,0 +1,194 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_SHARED_MODEL_REGISTRY_H_
+#define _EASY_DNN_SHARED_MODEL_REGISTRY_H_
+
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "easy_dnn/mapped_model.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Process wide registry of loaded packed models, keyed by the size and a
+ *    sampled hash of the model files. Modules loading the same models share
+ *    one packed dnn handle, so the weights are only uploaded to BPU memory
+ *    once.
+ * A key hit is confirmed by comparing the mapped files before sharing, a
+ *    miss costs no more than hashing the sampled bytes.
+ * The packed handle is released when the last holder drops its reference,
+ *    do not call `hbDNNRelease` on a shared handle.
+ */
+class SharedModelRegistry {
+ public:
+  /**
+   * Get singleton instance
+   * @return instance
+   */
+  static SharedModelRegistry *GetInstance() {
+    static SharedModelRegistry instance;
+    return &instance;
+  }
+
+  /**
+   * Get a loaded packed model with the same content, load it otherwise
+   * @param[out] model
+   * @param[in] model_files
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Acquire(std::shared_ptr<MappedPackedModel> &model,
+                  std::vector<std::string> const &model_files) {
+    // files are mapped once, the mapping is keyed, compared and kept by
+    // the model if it gets loaded
+    std::shared_ptr<MappedPackedModel> candidate(new MappedPackedModel());
+    int32_t ret = candidate->Map(model_files);
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    uint64_t key = Hash(*candidate);
+
+    // one acquirer per key compares or loads at a time, other keys are not
+    // blocked while a model is uploaded
+    std::vector<std::shared_ptr<MappedPackedModel>> loaded;
+    {
+      std::unique_lock<std::mutex> lck{mutex_};
+      cond_.wait(lck, [this, key]() { return loading_.count(key) == 0U; });
+      loading_.insert(key);
+      auto range = models_.equal_range(key);
+      for (auto it = range.first; it != range.second;) {
+        std::shared_ptr<MappedPackedModel> alive = it->second.lock();
+        if (alive) {
+          loaded.push_back(alive);
+          ++it;
+        } else {
+          it = models_.erase(it);
+        }
+      }
+    }
+
+    // equal keys are not trusted, contents must match to share
+    bool shared = false;
+    for (auto &alive : loaded) {
+      if (SameContent(*alive, *candidate)) {
+        model = alive;
+        shared = true;
+        break;
+      }
+    }
+    if (!shared) {
+      ret = candidate->Initialize();
+    }
+
+    std::lock_guard<std::mutex> lck{mutex_};
+    if (!shared && ret == DNN_SUCCESS) {
+      models_.emplace(key, candidate);
+      model = candidate;
+    }
+    loading_.erase(key);
+    cond_.notify_all();
+    return ret;
+  }
+
+  /**
+   * Get count of packed models alive in the registry
+   * @return count
+   */
+  int32_t GetModelCount() {
+    std::lock_guard<std::mutex> lck{mutex_};
+    int32_t count = 0;
+    for (auto it = models_.begin(); it != models_.end();) {
+      if (it->second.expired()) {
+        it = models_.erase(it);
+      } else {
+        count++;
+        ++it;
+      }
+    }
+    return count;
+  }
+
+ private:
+  SharedModelRegistry() = default;
+
+  /**
+   * 64-bit FNV-1a over the size, the head and the tail of each mapped model
+   *    file. Hashing whole files costs seconds for large models, the key only
+   *    has to tell different models apart cheaply, hits are confirmed by
+   *    `SameContent`
+   */
+  static uint64_t Hash(MappedPackedModel const &model) {
+    size_t const sample = 64U * 1024U;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (auto const &mapping : model.GetMappings()) {
+      auto const *data = static_cast<unsigned char const *>(mapping.first);
+      size_t size = mapping.second;
+      uint64_t size64 = static_cast<uint64_t>(size);
+      hash = Fnv(hash, reinterpret_cast<unsigned char const *>(&size64),
+                 sizeof(size64));
+      if (size <= 2U * sample) {
+        hash = Fnv(hash, data, size);
+      } else {
+        hash = Fnv(hash, data, sample);
+        hash = Fnv(hash, data + size - sample, sample);
+      }
+    }
+    return hash;
+  }
+
+  static uint64_t Fnv(uint64_t hash, unsigned char const *data, size_t size) {
+    uint64_t const prime = 0x100000001b3ULL;
+    for (size_t offset = 0U; offset < size; offset++) {
+      hash = (hash ^ data[offset]) * prime;
+    }
+    return hash;
+  }
+
+  static bool SameContent(MappedPackedModel const &lhs,
+                          MappedPackedModel const &rhs) {
+    auto const &lhs_mappings = lhs.GetMappings();
+    auto const &rhs_mappings = rhs.GetMappings();
+    if (lhs_mappings.size() != rhs_mappings.size()) {
+      return false;
+    }
+    for (size_t i = 0U; i < lhs_mappings.size(); i++) {
+      if (lhs_mappings[i].second != rhs_mappings[i].second ||
+          memcmp(lhs_mappings[i].first,
+                 rhs_mappings[i].first,
+                 lhs_mappings[i].second) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::set<uint64_t> loading_;
+  std::multimap<uint64_t, std::weak_ptr<MappedPackedModel>> models_;
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_SHARED_MODEL_REGISTRY_H_
@@ -40,6 +40,7 @@ typedef enum {
   DNN_INPUTS_INVALID = -6000258,
   DNN_INVALID_PLUGIN = -6000259,
   DNN_OUTPUTS_INVALID = -6000260,
+  DNN_TASK_CANCELED = -6000261,
 } DNNStatus;
 
 }  // namespace easy_dnn
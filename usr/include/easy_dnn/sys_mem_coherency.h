@@ -0,0 +1,232 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_SYS_MEM_COHERENCY_H_
+#define _EASY_DNN_SYS_MEM_COHERENCY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "dnn/hb_dnn.h"
+#include "dnn/hb_sys.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+struct CoherencyStatistics {
+  uint64_t clean_count;       // HB_SYS_MEM_CACHE_CLEAN performed
+  uint64_t invalidate_count;  // HB_SYS_MEM_CACHE_INVALIDATE performed
+  uint64_t skipped_count;     // flushes avoided, the cache was coherent
+};
+
+/**
+ * Ownership tracking of cached system memory.
+ * Each tracked buffer remembers whether CPU or BPU wrote it last, and only
+ *    the flush needed by the next access is done:
+ *    - CPU written, then read by BPU: clean
+ *    - BPU written, then accessed by CPU: invalidate
+ *    - otherwise nothing
+ * Buffers are identified by `virAddr`, untracked buffers are flushed every
+ *    time, as without tracking. Every CPU access to a tracked buffer must be
+ *    announced by `BeginCpuAccess`, otherwise CPU writes are not cleaned.
+ * Thread safe.
+ */
+class SysMemCoherency {
+ public:
+  /**
+   * Create a tracker
+   * @param[out] coherency
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(std::shared_ptr<SysMemCoherency> &coherency) {
+    coherency.reset(new SysMemCoherency());
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Start tracking a cached buffer, the CPU is taken as its last writer
+   * @param[in] mem
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Track(hbSysMem const &mem) {
+    if (mem.virAddr == nullptr) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lck{mutex_};
+    states_[mem.virAddr] = STATE_CPU_DIRTY;
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Stop tracking a buffer, e.g. before it is freed
+   * @param[in] mem
+   */
+  void Untrack(hbSysMem const &mem) {
+    std::lock_guard<std::mutex> lck{mutex_};
+    states_.erase(mem.virAddr);
+  }
+
+  /**
+   * Prepare a buffer for CPU access
+   * @param[in] mem
+   * @param[in] write, CPU writes the buffer, otherwise only reads it
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t BeginCpuAccess(hbSysMem &mem, bool write) {
+    std::unique_lock<std::mutex> lck{mutex_};
+    auto it = states_.find(mem.virAddr);
+    if (it == states_.end()) {
+      lck.unlock();
+      return Flush(mem, HB_SYS_MEM_CACHE_INVALIDATE);
+    }
+    bool stale = it->second == STATE_BPU_DIRTY;
+    if (write) {
+      it->second = STATE_CPU_DIRTY;
+    } else if (stale) {
+      it->second = STATE_CLEAN;
+    }
+    lck.unlock();
+    if (!stale) {
+      statistics_.skipped_count++;
+      return DNN_SUCCESS;
+    }
+    return Flush(mem, HB_SYS_MEM_CACHE_INVALIDATE);
+  }
+
+  /**
+   * Prepare a buffer for BPU access
+   * @param[in] mem
+   * @param[in] write, BPU writes the buffer, otherwise only reads it
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t BeginBpuAccess(hbSysMem &mem, bool write) {
+    std::unique_lock<std::mutex> lck{mutex_};
+    auto it = states_.find(mem.virAddr);
+    if (it == states_.end()) {
+      lck.unlock();
+      return Flush(mem, HB_SYS_MEM_CACHE_CLEAN);
+    }
+    bool dirty = it->second == STATE_CPU_DIRTY;
+    it->second = write ? STATE_BPU_DIRTY : STATE_CLEAN;
+    lck.unlock();
+    if (!dirty) {
+      statistics_.skipped_count++;
+      return DNN_SUCCESS;
+    }
+    return Flush(mem, HB_SYS_MEM_CACHE_CLEAN);
+  }
+
+  /**
+   * Prepare all planes of a tensor for BPU access
+   * @param[in] tensor
+   * @param[in] write, BPU writes the tensor, otherwise only reads it
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t BeginBpuAccess(hbDNNTensor &tensor, bool write) {
+    int32_t plane_count =
+        tensor.properties.tensorType == HB_DNN_IMG_TYPE_NV12_SEPARATE ? 2 : 1;
+    for (int32_t i = 0; i < plane_count; i++) {
+      int32_t ret = BeginBpuAccess(tensor.sysMem[i], write);
+      if (ret != DNN_SUCCESS) {
+        return ret;
+      }
+    }
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Prepare tensors and call `hbDNNInfer`, inputs are read and outputs are
+   *    written by BPU
+   * @param[out] task_handle
+   * @param[out] output
+   * @param[in] input
+   * @param[in] dnn_handle
+   * @param[in] infer_ctrl_param
+   * @param[in] input_count
+   * @param[in] output_count
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Infer(hbDNNTaskHandle_t *task_handle,
+                hbDNNTensor *output,
+                hbDNNTensor *input,
+                hbDNNHandle_t dnn_handle,
+                hbDNNInferCtrlParam *infer_ctrl_param,
+                int32_t input_count,
+                int32_t output_count) {
+    for (int32_t i = 0; i < input_count; i++) {
+      int32_t ret = BeginBpuAccess(input[i], false);
+      if (ret != DNN_SUCCESS) {
+        return ret;
+      }
+    }
+    for (int32_t i = 0; i < output_count; i++) {
+      int32_t ret = BeginBpuAccess(output[i], true);
+      if (ret != DNN_SUCCESS) {
+        return ret;
+      }
+    }
+    return hbDNNInfer(
+        task_handle, &output, input, dnn_handle, infer_ctrl_param);
+  }
+
+  /**
+   * Get statistics
+   * @param[out] statistics
+   */
+  void GetStatistics(CoherencyStatistics &statistics) const {
+    statistics.clean_count = statistics_.clean_count.load();
+    statistics.invalidate_count = statistics_.invalidate_count.load();
+    statistics.skipped_count = statistics_.skipped_count.load();
+  }
+
+ private:
+  typedef enum {
+    // CPU cache and memory agree
+    STATE_CLEAN = 0,
+    // CPU wrote, the cache may hold lines not in memory yet
+    STATE_CPU_DIRTY,
+    // BPU wrote, the cache may hold stale lines
+    STATE_BPU_DIRTY,
+  } State;
+
+  struct AtomicStatistics {
+    std::atomic<uint64_t> clean_count{0U};
+    std::atomic<uint64_t> invalidate_count{0U};
+    std::atomic<uint64_t> skipped_count{0U};
+  };
+
+  SysMemCoherency() = default;
+
+  int32_t Flush(hbSysMem &mem, int32_t flag) {
+    if (flag == HB_SYS_MEM_CACHE_CLEAN) {
+      statistics_.clean_count++;
+    } else {
+      statistics_.invalidate_count++;
+    }
+    return hbSysFlushMem(&mem, flag);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<void *, State> states_;
+  AtomicStatistics statistics_;
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_SYS_MEM_COHERENCY_H_
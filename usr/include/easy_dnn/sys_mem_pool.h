@@ -0,0 +1,492 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_SYS_MEM_POOL_H_
+#define _EASY_DNN_SYS_MEM_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "dnn/hb_sys.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+struct SysMemPoolStatistics {
+  uint64_t reserved_bytes;       // chunks and large blocks from hbSysAlloc*
+  uint64_t used_bytes;           // blocks handed out, rounded to size class
+  uint64_t requested_bytes;      // blocks handed out, as requested
+  uint64_t reserved_high_water;  // peak of reserved_bytes
+  uint64_t used_high_water;      // peak of used_bytes
+  uint32_t chunk_count;
+  // free share of reserved memory, blocks cached or not handed out
+  float external_fragmentation;
+  // share of used memory lost to size class rounding
+  float internal_fragmentation;
+};
+
+/**
+ * Size class pool allocator on top of `hbSysAllocMem`/`hbSysAllocCachedMem`.
+ * Contiguous chunks are split into power of 2 blocks buddy style,
+ *    `phyAddr` and `virAddr` of a block keep the same offset into its chunk,
+ *    so blocks can be used as `hbDNNTensor::sysMem` directly. Requests
+ *    larger than `chunk_size / 4` get their own allocation.
+ * A freed block merges with its free buddy, so memory of one size class is
+ *    reused by other classes, e.g. after a resolution change. Chunks which
+ *    become fully free are handed back to the system, one is kept as spare.
+ * Each thread keeps a small cache of free blocks of small size classes, the
+ *    shared free lists are only locked when a cache runs empty or full.
+ *    Cached blocks do not merge, `Trim` returns them to the pool.
+ * The pool must outlive all blocks allocated from it.
+ */
+class SysMemPool {
+ public:
+  /**
+   * Create a pool
+   * @param[out] pool
+   * @param[in] cached, allocate chunks by `hbSysAllocCachedMem`
+   * @param[in] chunk_size, byte size of one chunk, power of 2
+   * @param[in] min_block_size, byte size of the smallest class, power of 2
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(std::shared_ptr<SysMemPool> &pool,
+                        bool cached = true,
+                        uint32_t chunk_size = 4U << 20,
+                        uint32_t min_block_size = 64U) {
+    if (!IsPowerOf2(chunk_size) || !IsPowerOf2(min_block_size) ||
+        min_block_size > chunk_size / 4U) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    pool.reset(new SysMemPool(cached, chunk_size, min_block_size));
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Allocate a block, `mem.memSize` is set to `size`
+   * @param[out] mem
+   * @param[in] size
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Alloc(hbSysMem &mem, uint32_t size) {
+    if (size == 0U) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    int32_t size_class = SizeClass(size);
+    if (size_class < 0) {
+      int32_t ret = cached_ ? hbSysAllocCachedMem(&mem, size)
+                            : hbSysAllocMem(&mem, size);
+      if (ret != HB_SYS_SUCCESS) {
+        return ret;
+      }
+      AddReserved(size);
+      AddUsed(size, size);
+      return DNN_SUCCESS;
+    }
+
+    Block block;
+    size_t capacity = CacheCapacity(size_class);
+    if (capacity < 2U) {
+      std::lock_guard<std::mutex> lck{mutex_};
+      int32_t ret = AllocBlock(block, size_class);
+      if (ret != DNN_SUCCESS) {
+        return ret;
+      }
+    } else {
+      std::shared_ptr<ThreadCache> cache = LocalCache();
+      std::lock_guard<std::mutex> lck{cache->mutex};
+      std::vector<Block> &blocks = cache->blocks[size_class];
+      if (blocks.empty()) {
+        int32_t ret = Refill(blocks, size_class, capacity / 2U);
+        if (ret != DNN_SUCCESS) {
+          return ret;
+        }
+      }
+      block = blocks.back();
+      blocks.pop_back();
+    }
+    mem.phyAddr = block.phy_addr;
+    mem.virAddr = block.vir_addr;
+    mem.memSize = size;
+    AddUsed(ClassSize(size_class), size);
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Free a block allocated by `Alloc`, `mem` must not be modified
+   * @param[inout] mem, reset after free
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Free(hbSysMem &mem) {
+    if (mem.virAddr == nullptr || mem.memSize == 0U) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    uint32_t size = mem.memSize;
+    int32_t size_class = SizeClass(size);
+    if (size_class < 0) {
+      int32_t ret = hbSysFreeMem(&mem);
+      if (ret != HB_SYS_SUCCESS) {
+        return ret;
+      }
+      SubUsed(size, size);
+      SubReserved(size);
+    } else {
+      Block block{mem.phyAddr, mem.virAddr};
+      SubUsed(ClassSize(size_class), size);
+      size_t capacity = CacheCapacity(size_class);
+      if (capacity < 2U) {
+        std::lock_guard<std::mutex> lck{mutex_};
+        FreeBlock(block, size_class);
+      } else {
+        std::shared_ptr<ThreadCache> cache = LocalCache();
+        std::lock_guard<std::mutex> lck{cache->mutex};
+        std::vector<Block> &blocks = cache->blocks[size_class];
+        blocks.push_back(block);
+        if (blocks.size() >= capacity) {
+          Drain(blocks, size_class, capacity / 2U);
+        }
+      }
+    }
+    mem.phyAddr = 0U;
+    mem.virAddr = nullptr;
+    mem.memSize = 0U;
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Return blocks cached by all threads to the pool and hand back fully
+   *    free chunks to the system, e.g. after a resolution change
+   */
+  void Trim() {
+    std::vector<std::shared_ptr<ThreadCache>> caches;
+    {
+      std::lock_guard<std::mutex> lck{caches_mutex_};
+      caches = caches_;
+    }
+    for (auto &cache : caches) {
+      FlushCache(*cache);
+    }
+    std::lock_guard<std::mutex> lck{mutex_};
+    std::set<uint64_t> &free_chunks = free_blocks_[top_order_];
+    while (!free_chunks.empty()) {
+      uint64_t phy_addr = *free_chunks.begin();
+      free_chunks.erase(free_chunks.begin());
+      ReleaseChunk(phy_addr);
+    }
+  }
+
+  /**
+   * Get statistics
+   * @param[out] statistics
+   */
+  void GetStatistics(SysMemPoolStatistics &statistics) {
+    statistics.reserved_bytes = reserved_bytes_.load();
+    statistics.used_bytes = used_bytes_.load();
+    statistics.requested_bytes = requested_bytes_.load();
+    statistics.reserved_high_water = reserved_high_water_.load();
+    statistics.used_high_water = used_high_water_.load();
+    {
+      std::lock_guard<std::mutex> lck{mutex_};
+      statistics.chunk_count = static_cast<uint32_t>(chunks_.size());
+    }
+    statistics.external_fragmentation =
+        statistics.reserved_bytes == 0U
+            ? 0.0F
+            : 1.0F - static_cast<float>(statistics.used_bytes) /
+                         static_cast<float>(statistics.reserved_bytes);
+    statistics.internal_fragmentation =
+        statistics.used_bytes == 0U
+            ? 0.0F
+            : 1.0F - static_cast<float>(statistics.requested_bytes) /
+                         static_cast<float>(statistics.used_bytes);
+  }
+
+  ~SysMemPool() {
+    // drop the blocks of every thread cache, the weak references kept by
+    // the threads expire and are erased on their next cache lookup
+    for (auto &cache : caches_) {
+      std::lock_guard<std::mutex> lck{cache->mutex};
+      for (auto &blocks : cache->blocks) {
+        std::vector<Block>().swap(blocks);
+      }
+    }
+    caches_.clear();
+    for (auto &chunk : chunks_) {
+      hbSysFreeMem(&chunk.second);
+    }
+  }
+
+ private:
+  static constexpr uint32_t kCacheCapacity = 16U;
+  static constexpr uint32_t kCacheBytes = 64U << 10;
+  static constexpr size_t kSpareChunkCount = 1U;
+  static constexpr int32_t kMaxClassCount = 32;
+
+  struct Block {
+    uint64_t phy_addr;
+    void *vir_addr;
+  };
+
+  struct ThreadCache {
+    std::mutex mutex;  // uncontended except for `Trim` and orphan sweeps
+    bool orphaned{false};
+    std::vector<Block> blocks[kMaxClassCount];
+  };
+
+  // caches of the pools used by one thread, orphaned when the thread exits
+  struct LocalCaches {
+    std::map<uint64_t, std::weak_ptr<ThreadCache>> caches;
+
+    ~LocalCaches() {
+      for (auto &entry : caches) {
+        std::shared_ptr<ThreadCache> cache = entry.second.lock();
+        if (cache) {
+          std::lock_guard<std::mutex> lck{cache->mutex};
+          cache->orphaned = true;
+        }
+      }
+    }
+  };
+
+  SysMemPool(bool cached, uint32_t chunk_size, uint32_t min_block_size)
+      : cached_(cached),
+        chunk_size_(chunk_size),
+        min_block_size_(min_block_size),
+        id_(NextId()) {
+    uint32_t class_size = min_block_size;
+    while (class_size <= chunk_size / 4U) {
+      class_count_++;
+      class_size <<= 1;
+    }
+    top_order_ = class_count_ + 1;
+  }
+
+  static bool IsPowerOf2(uint32_t value) {
+    return value != 0U && (value & (value - 1U)) == 0U;
+  }
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> id{0U};
+    return ++id;
+  }
+
+  std::shared_ptr<ThreadCache> LocalCache() {
+    // keyed by a never reused id, caches of a destroyed pool are expired
+    thread_local LocalCaches local;
+    auto it = local.caches.find(id_);
+    if (it != local.caches.end()) {
+      std::shared_ptr<ThreadCache> cache = it->second.lock();
+      if (cache) {
+        return cache;
+      }
+    }
+    // first use of this pool by this thread
+    for (auto entry = local.caches.begin(); entry != local.caches.end();) {
+      if (entry->second.expired()) {
+        entry = local.caches.erase(entry);
+      } else {
+        ++entry;
+      }
+    }
+    std::shared_ptr<ThreadCache> cache = std::make_shared<ThreadCache>();
+    local.caches[id_] = cache;
+    std::vector<std::shared_ptr<ThreadCache>> orphans;
+    {
+      std::lock_guard<std::mutex> lck{caches_mutex_};
+      for (auto entry = caches_.begin(); entry != caches_.end();) {
+        std::lock_guard<std::mutex> cache_lck{(*entry)->mutex};
+        if ((*entry)->orphaned) {
+          orphans.push_back(*entry);
+          entry = caches_.erase(entry);
+        } else {
+          ++entry;
+        }
+      }
+      caches_.push_back(cache);
+    }
+    for (auto &orphan : orphans) {
+      FlushCache(*orphan);
+    }
+    return cache;
+  }
+
+  uint32_t ClassSize(int32_t size_class) const {
+    return min_block_size_ << size_class;
+  }
+
+  int32_t SizeClass(uint32_t size) const {
+    for (int32_t i = 0; i < class_count_; i++) {
+      if (size <= ClassSize(i)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // blocks cached per thread and size class, up to `kCacheBytes`
+  size_t CacheCapacity(int32_t size_class) const {
+    return std::min<size_t>(kCacheCapacity,
+                            kCacheBytes / ClassSize(size_class));
+  }
+
+  int32_t Refill(std::vector<Block> &blocks,
+                 int32_t size_class,
+                 size_t count) {
+    std::lock_guard<std::mutex> lck{mutex_};
+    for (size_t i = 0U; i < count; i++) {
+      Block block;
+      int32_t ret = AllocBlock(block, size_class);
+      if (ret != DNN_SUCCESS) {
+        return blocks.empty() ? ret : DNN_SUCCESS;
+      }
+      blocks.push_back(block);
+    }
+    return DNN_SUCCESS;
+  }
+
+  void Drain(std::vector<Block> &blocks, int32_t size_class, size_t count) {
+    std::lock_guard<std::mutex> lck{mutex_};
+    for (size_t i = blocks.size() - count; i < blocks.size(); i++) {
+      FreeBlock(blocks[i], size_class);
+    }
+    blocks.resize(blocks.size() - count);
+  }
+
+  void FlushCache(ThreadCache &cache) {
+    std::lock_guard<std::mutex> cache_lck{cache.mutex};
+    std::lock_guard<std::mutex> lck{mutex_};
+    for (int32_t i = 0; i < class_count_; i++) {
+      for (auto const &block : cache.blocks[i]) {
+        FreeBlock(block, i);
+      }
+      std::vector<Block>().swap(cache.blocks[i]);
+    }
+  }
+
+  // lowest free block of the order, split from a larger one if needed
+  int32_t AllocBlock(Block &block, int32_t order) {
+    int32_t split = order;
+    while (split <= top_order_ && free_blocks_[split].empty()) {
+      split++;
+    }
+    if (split > top_order_) {
+      hbSysMem chunk;
+      int32_t ret = cached_ ? hbSysAllocCachedMem(&chunk, chunk_size_)
+                            : hbSysAllocMem(&chunk, chunk_size_);
+      if (ret != HB_SYS_SUCCESS) {
+        return ret;
+      }
+      chunks_[chunk.phyAddr] = chunk;
+      AddReserved(chunk_size_);
+      split = top_order_;
+      free_blocks_[split].insert(chunk.phyAddr);
+    }
+    uint64_t phy_addr = *free_blocks_[split].begin();
+    free_blocks_[split].erase(free_blocks_[split].begin());
+    while (split > order) {
+      split--;
+      free_blocks_[split].insert(phy_addr + ClassSize(split));
+    }
+    hbSysMem const &chunk = FindChunk(phy_addr);
+    block.phy_addr = phy_addr;
+    block.vir_addr =
+        static_cast<uint8_t *>(chunk.virAddr) + (phy_addr - chunk.phyAddr);
+    return DNN_SUCCESS;
+  }
+
+  // merge with free buddies, hand back the chunk once it is fully free
+  void FreeBlock(Block const &block, int32_t order) {
+    uint64_t base = FindChunk(block.phy_addr).phyAddr;
+    uint64_t phy_addr = block.phy_addr;
+    for (; order < top_order_; order++) {
+      uint64_t buddy = base + ((phy_addr - base) ^ ClassSize(order));
+      auto it = free_blocks_[order].find(buddy);
+      if (it == free_blocks_[order].end()) {
+        break;
+      }
+      free_blocks_[order].erase(it);
+      phy_addr = std::min(phy_addr, buddy);
+    }
+    if (order == top_order_ &&
+        free_blocks_[top_order_].size() >= kSpareChunkCount) {
+      ReleaseChunk(phy_addr);
+      return;
+    }
+    free_blocks_[order].insert(phy_addr);
+  }
+
+  hbSysMem const &FindChunk(uint64_t phy_addr) const {
+    return std::prev(chunks_.upper_bound(phy_addr))->second;
+  }
+
+  void ReleaseChunk(uint64_t phy_addr) {
+    auto it = chunks_.find(phy_addr);
+    hbSysFreeMem(&it->second);
+    chunks_.erase(it);
+    SubReserved(chunk_size_);
+  }
+
+  static void UpdateHighWater(std::atomic<uint64_t> &high_water,
+                              uint64_t value) {
+    uint64_t current = high_water.load(std::memory_order_relaxed);
+    while (value > current &&
+           !high_water.compare_exchange_weak(current, value)) {
+    }
+  }
+
+  void AddReserved(uint64_t bytes) {
+    UpdateHighWater(reserved_high_water_, reserved_bytes_ += bytes);
+  }
+
+  void SubReserved(uint64_t bytes) { reserved_bytes_ -= bytes; }
+
+  void AddUsed(uint64_t bytes, uint64_t requested) {
+    UpdateHighWater(used_high_water_, used_bytes_ += bytes);
+    requested_bytes_ += requested;
+  }
+
+  void SubUsed(uint64_t bytes, uint64_t requested) {
+    used_bytes_ -= bytes;
+    requested_bytes_ -= requested;
+  }
+
+ private:
+  bool cached_;
+  uint32_t chunk_size_;
+  uint32_t min_block_size_;
+  int32_t class_count_{0};
+  int32_t top_order_{0};  // order of a whole chunk
+  uint64_t id_;
+  std::mutex mutex_;
+  std::map<uint64_t, hbSysMem> chunks_;  // keyed by phyAddr
+  std::set<uint64_t> free_blocks_[kMaxClassCount + 1];  // phyAddr per order
+  std::mutex caches_mutex_;
+  std::vector<std::shared_ptr<ThreadCache>> caches_;
+  std::atomic<uint64_t> reserved_bytes_{0U};
+  std::atomic<uint64_t> used_bytes_{0U};
+  std::atomic<uint64_t> requested_bytes_{0U};
+  std::atomic<uint64_t> reserved_high_water_{0U};
+  std::atomic<uint64_t> used_high_water_{0U};
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_SYS_MEM_POOL_H_
@@ -0,0 +1,169 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_SYS_MEM_UTILS_H_
+#define _EASY_DNN_SYS_MEM_UTILS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "dnn/hb_dnn.h"
+#include "dnn/hb_sys.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+struct SysMemRange {
+  hbSysMem *mem;
+  uint32_t offset;  // byte offset into mem
+  uint32_t size;    // byte size, 0 means to the end of mem
+};
+
+class SysMemUtils {
+ public:
+  static constexpr uint32_t kCacheLineSize = 64U;
+
+  /**
+   * Flush part of a cachable system memory, the range is widened to whole
+   *    cache lines and clipped to the memory
+   * @param[in] mem
+   * @param[in] offset, byte offset into mem
+   * @param[in] size, byte size, 0 means to the end of mem
+   * @param[in] flag, HB_SYS_MEM_CACHE_INVALIDATE or HB_SYS_MEM_CACHE_CLEAN
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t FlushMemRange(hbSysMem const &mem,
+                               uint32_t offset,
+                               uint32_t size,
+                               int32_t flag) {
+    hbSysMem range;
+    int32_t ret = GetRange(range, SysMemRange{const_cast<hbSysMem *>(&mem),
+                                              offset, size});
+    if (ret != DNN_SUCCESS) {
+      return ret;
+    }
+    return hbSysFlushMem(&range, flag);
+  }
+
+  /**
+   * Flush many ranges in one call, ranges which are adjacent or overlap in
+   *    both virtual and physical address are merged first
+   * @param[in] ranges
+   * @param[in] flag, HB_SYS_MEM_CACHE_INVALIDATE or HB_SYS_MEM_CACHE_CLEAN
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t FlushMemRanges(std::vector<SysMemRange> const &ranges,
+                                int32_t flag) {
+    std::vector<hbSysMem> regions;
+    regions.reserve(ranges.size());
+    for (auto const &range : ranges) {
+      hbSysMem region;
+      int32_t ret = GetRange(region, range);
+      if (ret != DNN_SUCCESS) {
+        return ret;
+      }
+      regions.push_back(region);
+    }
+    std::sort(regions.begin(),
+              regions.end(),
+              [](hbSysMem const &lhs, hbSysMem const &rhs) {
+                return lhs.virAddr < rhs.virAddr;
+              });
+
+    size_t count = 0U;
+    for (size_t i = 0U; i < regions.size(); i++) {
+      if (count > 0U && Mergeable(regions[count - 1U], regions[i])) {
+        hbSysMem &last = regions[count - 1U];
+        uint64_t end = std::max(Address(last) + last.memSize,
+                                Address(regions[i]) + regions[i].memSize);
+        last.memSize = static_cast<uint32_t>(end - Address(last));
+      } else {
+        regions[count++] = regions[i];
+      }
+    }
+    for (size_t i = 0U; i < count; i++) {
+      int32_t ret = hbSysFlushMem(&regions[i], flag);
+      if (ret != HB_SYS_SUCCESS) {
+        return ret;
+      }
+    }
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Flush the rows of an image roi
+   * @param[in] mem
+   * @param[in] stride, byte size of one row
+   * @param[in] roi, in pixels, right and bottom are inclusive
+   * @param[in] element_size, byte size of one pixel
+   * @param[in] flag, HB_SYS_MEM_CACHE_INVALIDATE or HB_SYS_MEM_CACHE_CLEAN
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t FlushMemRoi(hbSysMem const &mem,
+                             uint32_t stride,
+                             hbDNNRoi const &roi,
+                             uint32_t element_size,
+                             int32_t flag) {
+    if (roi.left < 0 || roi.top < 0 || roi.right < roi.left ||
+        roi.bottom < roi.top || element_size == 0U ||
+        (roi.right + 1) * element_size > stride) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    uint32_t begin = roi.top * stride + roi.left * element_size;
+    uint32_t end = roi.bottom * stride + (roi.right + 1) * element_size;
+    return FlushMemRange(mem, begin, end - begin, flag);
+  }
+
+ private:
+  static uint64_t Address(hbSysMem const &mem) {
+    return reinterpret_cast<uint64_t>(mem.virAddr);
+  }
+
+  static bool Mergeable(hbSysMem const &lhs, hbSysMem const &rhs) {
+    uint64_t lhs_end = Address(lhs) + lhs.memSize;
+    return Address(rhs) <= lhs_end &&
+           rhs.phyAddr - lhs.phyAddr == Address(rhs) - Address(lhs);
+  }
+
+  static int32_t GetRange(hbSysMem &range, SysMemRange const &mem_range) {
+    hbSysMem const *mem = mem_range.mem;
+    if (mem == nullptr || mem->virAddr == nullptr ||
+        mem_range.offset >= mem->memSize) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    uint64_t end = mem_range.size == 0U
+                       ? mem->memSize
+                       : static_cast<uint64_t>(mem_range.offset) +
+                             mem_range.size;
+    if (end > mem->memSize) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    // widen to cache lines of the virtual address, clipped to the memory
+    uint64_t base = reinterpret_cast<uint64_t>(mem->virAddr);
+    uint64_t begin = (base + mem_range.offset) & ~(kCacheLineSize - 1ULL);
+    begin = std::max(begin, base) - base;
+    end = ((base + end + kCacheLineSize - 1ULL) & ~(kCacheLineSize - 1ULL));
+    end = std::min<uint64_t>(end - base, mem->memSize);
+    range.phyAddr = mem->phyAddr + begin;
+    range.virAddr = static_cast<uint8_t *>(mem->virAddr) + begin;
+    range.memSize = static_cast<uint32_t>(end - begin);
+    return DNN_SUCCESS;
+  }
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_SYS_MEM_UTILS_H_
@@ -0,0 +1,198 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_TASK_TIMELINE_H_
+#define _EASY_DNN_TASK_TIMELINE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * One measured span of a task.
+ * `name` and `category` must point to strings with static lifetime, e.g.
+ *    "queued"/"queue", "running"/"bpu", or a plugin layer name with "cpu"
+ */
+struct TimelineEvent {
+  char const *name;
+  char const *category;
+  int32_t bpu_core_id;
+  int64_t custom_id;
+  int64_t begin_time;  // time of us, steady clock
+  int64_t end_time;    // time of us, steady clock
+};
+
+/**
+ * Fixed size ring of task spans, the oldest spans are overwritten.
+ * Recording is wait-free and takes no lock, so it can stay enabled on the
+ *    hot path; spans are exported on demand as Chrome trace JSON, which
+ *    chrome://tracing and Perfetto open directly.
+ */
+class TaskTimeline {
+ public:
+  /**
+   * Create a timeline
+   * @param[out] timeline
+   * @param[in] capacity, count of spans kept, rounded up to power of 2
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(std::shared_ptr<TaskTimeline> &timeline,
+                        uint32_t capacity = 4096U) {
+    if (capacity == 0U) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    timeline.reset(new TaskTimeline(capacity));
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Get current time in the clock used by spans
+   * @return time of us
+   */
+  static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /**
+   * Record one span
+   * @param[in] event
+   */
+  void Record(TimelineEvent const &event) {
+    uint64_t ticket = head_.fetch_add(1U, std::memory_order_relaxed);
+    Slot &slot = slots_[ticket & mask_];
+    // odd sequence marks the slot as being written
+    slot.sequence.store(ticket * 2U + 1U, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = event;
+    slot.sequence.store(ticket * 2U + 2U, std::memory_order_release);
+  }
+
+  /**
+   * Copy spans currently in the ring, from oldest to newest
+   * @param[out] events
+   */
+  void Snapshot(std::vector<TimelineEvent> &events) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t begin = head > mask_ + 1U ? head - mask_ - 1U : 0U;
+    for (uint64_t ticket = begin; ticket < head; ticket++) {
+      Slot const &slot = slots_[ticket & mask_];
+      uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence != ticket * 2U + 2U) {
+        continue;
+      }
+      TimelineEvent event = slot.event;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+        events.push_back(event);
+      }
+    }
+  }
+
+  /**
+   * Write spans as Chrome trace JSON, one process per BPU core and one
+   *    async track per span
+   * @param[in] os
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t DumpChromeTrace(std::ostream &os) const {
+    std::vector<TimelineEvent> events;
+    Snapshot(events);
+    os << "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); i++) {
+      TimelineEvent const &event = events[i];
+      std::string name = EscapeJson(event.name);
+      std::string category = EscapeJson(event.category);
+      os << (i == 0 ? "" : ",") << "\n{\"name\":\"" << name << "\",\"cat\":\""
+         << category << "\",\"ph\":\"b\",\"id\":" << i
+         << ",\"pid\":" << event.bpu_core_id << ",\"tid\":0"
+         << ",\"ts\":" << event.begin_time
+         << ",\"args\":{\"custom_id\":" << event.custom_id
+         << ",\"bpu_core_id\":" << event.bpu_core_id << "}}";
+      os << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << category
+         << "\",\"ph\":\"e\",\"id\":" << i << ",\"pid\":" << event.bpu_core_id
+         << ",\"tid\":0,\"ts\":" << event.end_time << "}";
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return os.good() ? DNN_SUCCESS : DNN_API_USE_ERROR;
+  }
+
+  /**
+   * Write spans as Chrome trace JSON file
+   * @param[in] file
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t DumpChromeTrace(std::string const &file) const {
+    std::ofstream ofs(file);
+    if (!ofs.is_open()) {
+      return DNN_CAN_NOT_OPEN_FILE;
+    }
+    return DumpChromeTrace(static_cast<std::ostream &>(ofs));
+  }
+
+ private:
+  // escape a string for a JSON string literal, nullptr is empty
+  static std::string EscapeJson(char const *value) {
+    std::string escaped;
+    for (char const *c = value; c != nullptr && *c != '\0'; c++) {
+      auto byte = static_cast<unsigned char>(*c);
+      if (byte == '"' || byte == '\\') {
+        escaped += '\\';
+        escaped += *c;
+      } else if (byte < 0x20U) {
+        char const *hex = "0123456789abcdef";
+        escaped += "\\u00";
+        escaped += hex[byte >> 4];
+        escaped += hex[byte & 0xfU];
+      } else {
+        escaped += *c;
+      }
+    }
+    return escaped;
+  }
+
+  struct Slot {
+    std::atomic<uint64_t> sequence{0U};
+    TimelineEvent event;
+  };
+
+  explicit TaskTimeline(uint32_t capacity) : head_(0U) {
+    uint64_t size = 1U;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots_.reset(new Slot[size]);
+    mask_ = size - 1U;
+  }
+
+ private:
+  std::unique_ptr<Slot[]> slots_;
+  uint64_t mask_;
+  std::atomic<uint64_t> head_;
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_TASK_TIMELINE_H_
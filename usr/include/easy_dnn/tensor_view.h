@@ -0,0 +1,316 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_TENSOR_VIEW_H_
+#define _EASY_DNN_TENSOR_VIEW_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "dnn/hb_dnn.h"
+#include "easy_dnn/byte_swap.h"
+#include "easy_dnn/layout_convert.h"
+#include "easy_dnn/status.h"
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Typed view of the aligned buffer of a tensor.
+ * Elements of `validShape` are addressed by `properties.stride`, so
+ *    post-processing reads outputs and producers write inputs in place,
+ *    without `hbDNNRemovePaddingWithStride` / `hbDNNAddPaddingWithStride`
+ *    copies. `ToDense` and `FromDense` copy only when dense memory is
+ *    really needed.
+ * The view does not own memory, the tensor must outlive it.
+ * Use a const element type, e.g. `TensorView<int8_t const>`, for reading.
+ */
+template <typename T>
+class TensorView {
+ public:
+  typedef typename std::remove_const<T>::type ValueType;
+
+  TensorView() = default;
+
+  /**
+   * Create a view of a tensor
+   * @param[out] view
+   * @param[in] tensor, element size of `tensorType` must be `sizeof(T)`
+   * @return 0 if success, return defined error code otherwise
+   */
+  static int32_t Create(TensorView &view, hbDNNTensor const &tensor) {
+    hbDNNTensorProperties const &properties = tensor.properties;
+    int32_t dim_num = properties.validShape.numDimensions;
+    if (tensor.sysMem[0].virAddr == nullptr || dim_num <= 0 ||
+        dim_num > HB_DNN_TENSOR_MAX_DIMENSIONS ||
+        properties.alignedShape.numDimensions != dim_num ||
+        LayoutConvert::ElementSize(properties.tensorType) !=
+            static_cast<int32_t>(sizeof(T))) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    for (int32_t i = 0; i < dim_num; i++) {
+      if (properties.validShape.dimensionSize[i] <= 0 ||
+          properties.validShape.dimensionSize[i] >
+              properties.alignedShape.dimensionSize[i] ||
+          properties.stride[i] < static_cast<int32_t>(sizeof(T))) {
+        return DNN_INVALID_ARGUMENT;
+      }
+    }
+    view.data_ = static_cast<Byte *>(tensor.sysMem[0].virAddr);
+    view.dim_num_ = dim_num;
+    for (int32_t i = 0; i < dim_num; i++) {
+      view.shape_[i] = properties.validShape.dimensionSize[i];
+      view.aligned_[i] = properties.alignedShape.dimensionSize[i];
+      view.stride_[i] = static_cast<size_t>(properties.stride[i]);
+    }
+    return DNN_SUCCESS;
+  }
+
+  int32_t GetDimensionCount() const { return dim_num_; }
+
+  /**
+   * Get valid size of a dimension
+   * @param[in] dim
+   * @return size
+   */
+  int32_t GetSize(int32_t dim) const { return shape_[dim]; }
+
+  /**
+   * Get byte stride of a dimension
+   * @param[in] dim
+   * @return stride
+   */
+  size_t GetStride(int32_t dim) const { return stride_[dim]; }
+
+  /**
+   * Get count of valid elements
+   * @return count
+   */
+  size_t GetElementCount() const {
+    size_t count = 1U;
+    for (int32_t i = 0; i < dim_num_; i++) {
+      count *= static_cast<size_t>(shape_[i]);
+    }
+    return count;
+  }
+
+  /**
+   * Check whether valid elements are stored without gaps
+   * @return true if dense
+   */
+  bool IsDense() const {
+    size_t stride = sizeof(T);
+    for (int32_t i = dim_num_ - 1; i >= 0; i--) {
+      if (stride_[i] != stride) {
+        return false;
+      }
+      stride *= static_cast<size_t>(shape_[i]);
+    }
+    return true;
+  }
+
+  /**
+   * Get an element, one index per dimension, e.g. `view(n, h, w, c)`
+   * @return element
+   */
+  template <typename... Index>
+  T &operator()(Index... index) const {
+    static_assert(sizeof...(Index) > 0U, "index required");
+    assert(sizeof...(Index) <= static_cast<size_t>(dim_num_));
+    size_t const offsets[] = {static_cast<size_t>(index)...};
+    size_t offset = 0U;
+    for (size_t i = 0U; i < sizeof...(Index); i++) {
+      offset += offsets[i] * stride_[i];
+    }
+    return *reinterpret_cast<T *>(data_ + offset);
+  }
+
+  /**
+   * Get an element
+   * @param[in] index, `GetDimensionCount()` indices
+   * @return element
+   */
+  T &At(int32_t const *index) const {
+    return *reinterpret_cast<T *>(data_ + Offset(index, dim_num_));
+  }
+
+  /**
+   * Get the innermost row at an index, its elements are
+   *    `GetStride(GetDimensionCount() - 1)` bytes apart
+   * @param[in] index, `GetDimensionCount() - 1` leading indices
+   * @return first element of the row
+   */
+  T *Row(int32_t const *index) const {
+    return reinterpret_cast<T *>(data_ + Offset(index, dim_num_ - 1));
+  }
+
+  /**
+   * Narrow a dimension to [begin, end), the view keeps referring to the
+   *    same buffer. Elements past `end` belong to the parent, so a sliced
+   *    view has no padding of its own and refuses `ZeroPadding`
+   * @param[out] view
+   * @param[in] dim
+   * @param[in] begin
+   * @param[in] end
+   * @return 0 if success, return defined error code otherwise
+   */
+  int32_t Slice(TensorView &view,
+                int32_t dim,
+                int32_t begin,
+                int32_t end) const {
+    if (dim < 0 || dim >= dim_num_ || begin < 0 || begin >= end ||
+        end > shape_[dim]) {
+      return DNN_INVALID_ARGUMENT;
+    }
+    view = *this;
+    view.data_ += static_cast<size_t>(begin) * stride_[dim];
+    view.shape_[dim] = end - begin;
+    view.sliced_ = true;
+    return DNN_SUCCESS;
+  }
+
+  /**
+   * Copy valid elements to dense memory, one `memcpy` if the view is
+   *    already dense
+   * @param[out] output, `GetElementCount()` elements
+   * @param[in] convert_endianness, reverse bytes of each element
+   */
+  void ToDense(ValueType *output, bool convert_endianness = false) const {
+    Copy(reinterpret_cast<uint8_t *>(output), data_, false, convert_endianness);
+  }
+
+  /**
+   * Copy dense memory to valid elements, padding is not touched
+   * @param[in] input, `GetElementCount()` elements
+   * @param[in] convert_endianness, reverse bytes of each element
+   */
+  void FromDense(ValueType const *input,
+                 bool convert_endianness = false) const {
+    Copy(data_,
+         reinterpret_cast<uint8_t const *>(input),
+         true,
+         convert_endianness);
+  }
+
+  /**
+   * Zero the elements between valid and aligned shape, e.g. after a
+   *    producer wrote the valid elements of an input tensor in place
+   * @return 0 if success, `DNN_API_USE_ERROR` for a sliced view
+   */
+  int32_t ZeroPadding() const {
+    if (sliced_) {
+      return DNN_API_USE_ERROR;
+    }
+    int32_t last = dim_num_ - 1;
+    size_t row_bytes = static_cast<size_t>(aligned_[last]) * stride_[last];
+    size_t valid_bytes = static_cast<size_t>(shape_[last]) * stride_[last];
+    size_t row_count = 1U;
+    for (int32_t i = 0; i < last; i++) {
+      row_count *= static_cast<size_t>(aligned_[i]);
+    }
+    for (size_t r = 0U; r < row_count; r++) {
+      size_t row = r;
+      size_t offset = 0U;
+      bool inside = true;
+      for (int32_t i = last - 1; i >= 0; i--) {
+        size_t index = row % static_cast<size_t>(aligned_[i]);
+        row /= static_cast<size_t>(aligned_[i]);
+        offset += index * stride_[i];
+        inside = inside && index < static_cast<size_t>(shape_[i]);
+      }
+      if (inside) {
+        memset(data_ + offset + valid_bytes, 0, row_bytes - valid_bytes);
+      } else {
+        memset(data_ + offset, 0, row_bytes);
+      }
+    }
+    return DNN_SUCCESS;
+  }
+
+ private:
+  typedef typename std::conditional<std::is_const<T>::value,
+                                    uint8_t const,
+                                    uint8_t>::type Byte;
+
+  size_t Offset(int32_t const *index, int32_t count) const {
+    size_t offset = 0U;
+    for (int32_t i = 0; i < count; i++) {
+      offset += static_cast<size_t>(index[i]) * stride_[i];
+    }
+    return offset;
+  }
+
+  // dense side is `dst` if `to_view`, `src` otherwise
+  void Copy(uint8_t *dst, uint8_t const *src, bool to_view, bool swap) const {
+    if (IsDense()) {
+      CopyRun(dst, src, GetElementCount(), swap);
+      return;
+    }
+    // merge trailing dimensions which are dense into one run
+    int32_t last = dim_num_ - 1;
+    size_t run = static_cast<size_t>(shape_[last]);
+    size_t step = stride_[last];
+    while (step == sizeof(T) && last > 0 &&
+           stride_[last - 1] == run * sizeof(T)) {
+      last--;
+      run *= static_cast<size_t>(shape_[last]);
+    }
+    size_t run_count = GetElementCount() / run;
+    for (size_t r = 0U; r < run_count; r++) {
+      size_t row = r;
+      size_t offset = 0U;
+      for (int32_t i = last - 1; i >= 0; i--) {
+        offset += row % static_cast<size_t>(shape_[i]) * stride_[i];
+        row /= static_cast<size_t>(shape_[i]);
+      }
+      uint8_t *d = dst + (to_view ? offset : r * run * sizeof(T));
+      uint8_t const *s = src + (to_view ? r * run * sizeof(T) : offset);
+      if (step == sizeof(T)) {
+        CopyRun(d, s, run, swap);
+        continue;
+      }
+      size_t dst_step = to_view ? step : sizeof(T);
+      size_t src_step = to_view ? sizeof(T) : step;
+      for (size_t i = 0U; i < run; i++) {
+        CopyRun(d + i * dst_step, s + i * src_step, 1U, swap);
+      }
+    }
+  }
+
+  static void CopyRun(uint8_t *dst,
+                      uint8_t const *src,
+                      size_t count,
+                      bool swap) {
+    if (swap) {
+      ByteSwap::Swap(dst, src, count, sizeof(T));
+    } else {
+      memcpy(dst, src, count * sizeof(T));
+    }
+  }
+
+ private:
+  Byte *data_{nullptr};
+  int32_t dim_num_{0};
+  int32_t shape_[HB_DNN_TENSOR_MAX_DIMENSIONS]{};
+  int32_t aligned_[HB_DNN_TENSOR_MAX_DIMENSIONS]{};
+  size_t stride_[HB_DNN_TENSOR_MAX_DIMENSIONS]{};
+  bool sliced_{false};  // narrowed by `Slice`
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_TENSOR_VIEW_H_
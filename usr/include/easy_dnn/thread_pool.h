@@ -0,0 +1,162 @@
+// Copyright (c) [2021-2023] [Horizon Robotics].
+//
+// You can use this software according to the terms and conditions of
+// the Apache v2.0.
+// You may obtain a copy of Apache v2.0. at:
+//
+//     http: //www.apache.org/licenses/LICENSE-2.0
+//
+// THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// NON-INFRINGEMENT, MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+// See Apache v2.0 for more details.
+
+#ifndef _EASY_DNN_THREAD_POOL_H_
+#define _EASY_DNN_THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hobot {
+namespace easy_dnn {
+
+/**
+ * Worker threads for data parallel CPU kernels.
+ * `ParallelFor` splits a range into chunks, the calling thread runs chunks
+ *    too, so it completes even if all workers are busy with other calls.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Get the shared pool, one worker less than hardware concurrency
+   * @return pool
+   */
+  static ThreadPool &GetInstance() {
+    static ThreadPool pool(
+        std::max(1U, std::thread::hardware_concurrency()) - 1U);
+    return pool;
+  }
+
+  explicit ThreadPool(uint32_t thread_count) {
+    for (uint32_t i = 0U; i < thread_count; i++) {
+      threads_.emplace_back(&ThreadPool::Run, this);
+    }
+  }
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+
+  /**
+   * Get count of threads running a `ParallelFor`, including the caller
+   * @return thread count
+   */
+  int32_t GetThreadCount() const {
+    return static_cast<int32_t>(threads_.size()) + 1;
+  }
+
+  /**
+   * Run `fn(begin, end)` over sub ranges of [0, count), returns when all
+   *    sub ranges are done
+   * @param[in] count
+   * @param[in] grain, minimal size of a sub range
+   * @param[in] fn
+   */
+  void ParallelFor(size_t count,
+                   size_t grain,
+                   std::function<void(size_t, size_t)> const &fn) {
+    grain = std::max<size_t>(grain, 1U);
+    size_t chunk_count = std::min<size_t>(
+        (count + grain - 1U) / grain, static_cast<size_t>(GetThreadCount()));
+    if (chunk_count <= 1U) {
+      if (count > 0U) {
+        fn(0U, count);
+      }
+      return;
+    }
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->count = count;
+    job->chunk_count = chunk_count;
+    job->pending = chunk_count;
+    {
+      std::lock_guard<std::mutex> lck{mutex_};
+      jobs_.push_back(job);
+    }
+    cv_.notify_all();
+    RunChunks(*job);
+    std::unique_lock<std::mutex> lck{mutex_};
+    done_cv_.wait(lck, [&job] { return job->pending.load() == 0U; });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lck{mutex_};
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+ private:
+  struct Job {
+    std::function<void(size_t, size_t)> const *fn;
+    size_t count;
+    size_t chunk_count;
+    std::atomic<size_t> next{0U};
+    std::atomic<size_t> pending{0U};
+  };
+
+  void RunChunks(Job &job) {
+    for (size_t i = job.next++; i < job.chunk_count; i = job.next++) {
+      (*job.fn)(job.count * i / job.chunk_count,
+                job.count * (i + 1U) / job.chunk_count);
+      if (--job.pending == 0U) {
+        // lock so the waiting caller can not miss the notify
+        std::lock_guard<std::mutex> lck{mutex_};
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  void Run() {
+    std::unique_lock<std::mutex> lck{mutex_};
+    while (true) {
+      cv_.wait(lck, [this] { return stop_ || !jobs_.empty(); });
+      if (stop_) {
+        return;
+      }
+      std::shared_ptr<Job> job = jobs_.front();
+      if (job->next.load() >= job->chunk_count) {
+        // all chunks taken, running ones finish without the queue
+        jobs_.pop_front();
+        continue;
+      }
+      lck.unlock();
+      RunChunks(*job);
+      lck.lock();
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable done_cv_;
+  std::deque<std::shared_ptr<Job>> jobs_;
+  std::vector<std::thread> threads_;
+  bool stop_{false};
+};
+
+}  // namespace easy_dnn
+}  // namespace hobot
+
+#endif  // _EASY_DNN_THREAD_POOL_H_